@@ -0,0 +1,123 @@
+# Build the static web assets into src/web_assets.h.
+#
+# Each file in web/ is minified, gzip-compressed and written out as a flash
+# byte array, together with a table the web server registers routes from.
+# WEB_ASSETS_HASH (a hash of all compressed assets) versions the cacheable
+# URLs so a firmware with changed assets bypasses the browser cache.
+#
+# Runs before every PlatformIO build (extra_scripts = pre:...), and also
+# standalone: python scripts/web_assets.py
+
+import gzip
+import hashlib
+import os
+import re
+
+# file in web/ -> (URL, content type, cacheable). Cacheable assets are
+# referenced with ?v=WEB_ASSETS_HASH and may be cached for a year; the others
+# are revalidated with the hash as ETag.
+ASSETS = [
+    ("status.css",  "/status.css", "text/css",               True),
+    ("status.js",   "/status.js",  "application/javascript", True),
+    ("update.html", "/update",     "text/html",              False),
+]
+
+
+def minify_css(text):
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    text = re.sub(r"\s+", " ", text)
+    text = re.sub(r"\s*([{}:;,>])\s*", r"\1", text)
+    return text.replace(";}", "}").strip()
+
+
+def minify_js(text):
+    # Conservative: keep line breaks (automatic semicolon insertion) and
+    # drop only indentation, blank lines and whole-line comments.
+    lines = (line.strip() for line in text.splitlines())
+    return "\n".join(line for line in lines if line and not line.startswith("//"))
+
+
+def minify_html(text):
+    text = re.sub(r"<!--.*?-->", "", text, flags=re.S)
+    text = re.sub(r"<style>(.*?)</style>", lambda m: "<style>" + minify_css(m.group(1)) + "</style>", text, flags=re.S)
+    text = re.sub(r"<script>(.*?)</script>", lambda m: "<script>" + minify_js(m.group(1)) + "</script>", text, flags=re.S)
+    lines = (line.strip() for line in text.splitlines())
+    return "\n".join(line for line in lines if line)
+
+
+MINIFIERS = {".css": minify_css, ".js": minify_js, ".html": minify_html}
+
+
+def c_name(filename):
+    return re.sub(r"\W", "_", filename) + "_gz"
+
+
+def build(project_dir):
+    web_dir = os.path.join(project_dir, "web")
+    out_path = os.path.join(project_dir, "src", "web_assets.h")
+
+    blobs = []
+    digest = hashlib.sha1()
+    for filename, url, content_type, cacheable in ASSETS:
+        with open(os.path.join(web_dir, filename), encoding="utf-8") as f:
+            text = f.read()
+        text = MINIFIERS[os.path.splitext(filename)[1]](text)
+        data = gzip.compress(text.encode("utf-8"), compresslevel=9, mtime=0)
+        digest.update(data)
+        blobs.append((filename, url, content_type, cacheable, data, len(text)))
+
+    out = [
+        "// Generated by scripts/web_assets.py from web/ — do not edit",
+        "#ifndef WEB_ASSETS_H",
+        "#define WEB_ASSETS_H",
+        "",
+        "#include <Arduino.h>",
+        "",
+        '#define WEB_ASSETS_HASH "%s"' % digest.hexdigest()[:8],
+        "",
+    ]
+    for filename, url, content_type, cacheable, data, raw_len in blobs:
+        out.append("// %s: %u bytes minified, %u gzipped" % (filename, raw_len, len(data)))
+        out.append("static const uint8_t %s[] PROGMEM = {" % c_name(filename))
+        for i in range(0, len(data), 16):
+            out.append("    " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+        out.append("};")
+        out.append("")
+    out += [
+        "struct WebAsset {",
+        "    const char*    url;",
+        "    const char*    contentType;",
+        "    bool           cacheable; // URL carries ?v=WEB_ASSETS_HASH",
+        "    const uint8_t* gzip;",
+        "    size_t         gzipLen;",
+        "};",
+        "",
+        "static const WebAsset webAssets[] = {",
+    ]
+    for filename, url, content_type, cacheable, data, raw_len in blobs:
+        out.append('    {"%s", "%s", %s, %s, sizeof(%s)},'
+                   % (url, content_type, "true" if cacheable else "false", c_name(filename), c_name(filename)))
+    out += [
+        "};",
+        "",
+        "#endif // WEB_ASSETS_H",
+        "",
+    ]
+    text = "\n".join(out)
+
+    # Leave the header untouched when nothing changed, so it does not force a rebuild
+    if os.path.exists(out_path):
+        with open(out_path, encoding="utf-8") as f:
+            if f.read() == text:
+                return
+    with open(out_path, "w", encoding="utf-8") as f:
+        f.write(text)
+    print("web_assets.py: wrote %s (%s)" % (out_path, digest.hexdigest()[:8]))
+
+
+try:
+    Import("env")  # noqa: F821 — provided by PlatformIO/SCons
+    build(env["PROJECT_DIR"])  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        build(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
@@ -0,0 +1,37 @@
+#include "battery.h"
+#include "metrics.h"
+
+struct CurvePoint {
+    float volts;
+    float percent;
+};
+
+// Resting voltage vs charge for a typical LiPo / 18650 cell at low load
+static const CurvePoint dischargeCurve[] = {
+    {3.00f,   0.0f}, {3.30f,   2.0f}, {3.50f,   6.0f}, {3.60f,  12.0f},
+    {3.70f,  28.0f}, {3.75f,  42.0f}, {3.80f,  55.0f}, {3.85f,  65.0f},
+    {3.90f,  74.0f}, {3.95f,  81.0f}, {4.00f,  87.0f}, {4.10f,  95.0f},
+    {4.20f, 100.0f},
+};
+static constexpr uint8_t CURVE_POINTS = sizeof(dischargeCurve) / sizeof(dischargeCurve[0]);
+
+float batterySocPercent(float volts) {
+    if (!(volts > 0.0f)) return NAN;
+    if (volts <= dischargeCurve[0].volts) return 0.0f;
+    for (uint8_t i = 1; i < CURVE_POINTS; i++) {
+        const CurvePoint& lo = dischargeCurve[i - 1];
+        const CurvePoint& hi = dischargeCurve[i];
+        if (volts <= hi.volts) {
+            return lo.percent + (hi.percent - lo.percent) * (volts - lo.volts) / (hi.volts - lo.volts);
+        }
+    }
+    return 100.0f;
+}
+
+float batteryDaysLeft(float socPercent) {
+    float currentUa = wakeProfileMeanCurrentUa();
+    if (isnan(socPercent) || currentUa <= 0.0f) return NAN;
+    float capacityMah = boardConfig.battCapacityMah ? boardConfig.battCapacityMah : BATT_CAPACITY_DEFAULT_MAH;
+    float remainingUah = capacityMah * 1000.0f * socPercent / 100.0f;
+    return remainingUah / currentUa / 24.0f;
+}
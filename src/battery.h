@@ -0,0 +1,17 @@
+#ifndef BATTERY_H
+#define BATTERY_H
+
+#include "globals.h"
+
+// ── Battery state of charge and remaining life (battery boards) ───────────
+// State of charge comes from the smoothed voltage and a typical 1S Li-ion
+// open-circuit discharge curve (piecewise linear, 3.0 V = empty, 4.2 V =
+// full). Remaining life divides the charge left in BoardConfig.battCapacityMah
+// by the wake profiler's mean current over whole wake + sleep cycles, so it
+// follows measured awake time and the chosen sleep interval.
+// Readings taken while charging (see BATT_RISING_DELTA_V) are not estimated.
+
+float batterySocPercent(float volts); // 0–100, NAN if volts is not a reading
+float batteryDaysLeft(float socPercent); // NAN until the profiler has a full cycle
+
+#endif // BATTERY_H
@@ -20,6 +20,8 @@ static const char* const MQTT_TEMP_TOPIC    = "/tempset-ambient/set";
 static const char* const MQTT_HUMID_TOPIC   = "/tempset-humidity/set";
 static const char* const MQTT_DEBUG_TOPIC   = "/debug";
 static const char* const MQTT_BATTERY_TOPIC = "/battery/set";
+static const char* const MQTT_BATTERY_SOC_TOPIC  = "/battery-soc/set";  // state of charge (%)
+static const char* const MQTT_BATTERY_DAYS_TOPIC = "/battery-days/set"; // projected remaining life (days)
 static const char* const MQTT_CO2_TOPIC     = "/co2/set";
 static const char* const MQTT_PM1_TOPIC     = "/pm1/set";
 static const char* const MQTT_PM25_TOPIC    = "/pm25/set";
@@ -30,8 +32,23 @@ static const char* const MQTT_JSY_POWER_TOPIC         = "/ac-power/set";
 static const char* const MQTT_JSY_PF_TOPIC            = "/ac-pf/set";
 static const char* const MQTT_JSY_FREQ_TOPIC          = "/ac-freq/set";
 static const char* const MQTT_JSY_ENERGY_TOPIC        = "/ac-energy/set";
-static const char* const MQTT_JSY_DAILY_ENERGY_TOPIC  = "/ac-energy-daily/set";
+static const char* const MQTT_JSY_DIRECTION_TOPIC     = "/ac-direction/set"; // 0 = import, 1 = export
+static const char* const MQTT_JSY2_VOLTAGE_TOPIC      = "/ac2-voltage/set";  // Channel 2
+static const char* const MQTT_JSY2_CURRENT_TOPIC      = "/ac2-current/set";
+static const char* const MQTT_JSY2_POWER_TOPIC        = "/ac2-power/set";
+static const char* const MQTT_JSY2_PF_TOPIC           = "/ac2-pf/set";
+static const char* const MQTT_JSY2_ENERGY_TOPIC       = "/ac2-energy/set";
+static const char* const MQTT_JSY2_DIRECTION_TOPIC    = "/ac2-direction/set";
+static const char* const MQTT_JSY_DAILY_ENERGY_TOPIC  = "/ac-energy-daily/set";   // running kWh today
+static const char* const MQTT_JSY_MONTHLY_ENERGY_TOPIC = "/ac-energy-monthly/set"; // running kWh this month
+static const char* const MQTT_JSY_LAST_HOUR_ENERGY_TOPIC  = "/ac-energy-last-hour/set";  // retained, completed buckets
+static const char* const MQTT_JSY_YESTERDAY_ENERGY_TOPIC  = "/ac-energy-yesterday/set";
+static const char* const MQTT_JSY_LAST_MONTH_ENERGY_TOPIC = "/ac-energy-last-month/set";
+static const char* const MQTT_JSY_INTERVAL_ENERGY_TOPIC = "/ac-energy-interval/set"; // Wh integrated over the publish interval
+static const char* const MQTT_JSY_STATS_TOPIC         = "/ac-stats";  // JSON min/max/mean/stddev per publish interval
 static const char* const MQTT_IR_AC_TOPIC             = "/ir-ac/set"; // subscribe: receive AC commands
+static const char* const MQTT_METRICS_TOPIC           = "/metrics";   // cycle phase timing, one subtopic per phase
+static const char* const MQTT_SLEEP_TOPIC             = "/sleep-interval/set"; // battery: next sleep (s), adaptive or fixed
 
 // OTA Update server details
 static const char* const OTA_HOST = "YOUR_SERVER_IP_OR_DOMAIN";
@@ -46,19 +63,47 @@ static constexpr int  DAYLIGHT_OFFSET_SEC = 0;    // Additional DST offset (0 if
 
 // Other constants
 static constexpr int WIFI_RETRIES = 5;               // Number of times to retry WiFi before a restart
+static constexpr int WIFI_ATTEMPT_TIMEOUT_MS = 4000;  // Max wait for one association attempt (ms)
+static constexpr int WIFI_POLL_INTERVAL_MS = 50;      // Association status poll period — join returns as soon as connected
 static constexpr int MQTT_RETRIES = 5;               // Number of times to retry MQTT before a restart
 static constexpr int DHT_RETRIES = 5;                // Number of times to retry DHT reads before giving up
-static constexpr int DHT_INITIAL_DELAY_MS = 2000;   // Guard delay before first DHT read (ms) — DHT22 minimum is 1 s; 2 s gives outdoor margin
+static constexpr int DHT_INITIAL_DELAY_MS = 2000;   // Guard from DHT power-on to first read (ms) — DHT22 minimum is 1 s; 2 s gives outdoor margin
 static constexpr int DHT_RETRY_DELAY_MS = 2000;     // Delay between DHT retries — DHT22 needs >=2 s between reads
-static constexpr int VOLT_READS = 10;                // Number of times to read the voltage for averaging
-static constexpr float RAW_VOLTS_CONVERSION = 620.5; // Mapping raw input back to voltage 4095 / 3.3 * voltage divider factor (2)
+static constexpr uint16_t BATT_BURST_SAMPLES = 64;   // Back-to-back ADC samples averaged per battery reading (~2 ms, no delays)
+static constexpr float BATT_DIVIDER_DEFAULT = 2.0f;  // Battery divider ratio when BoardConfig.battDividerFactor is 0
 static constexpr float BATT_RISING_DELTA_V = 0.05f;  // Skip battery publish if voltage rose by this much since last reading (charging detection)
+static constexpr uint16_t BATT_CAPACITY_DEFAULT_MAH = 2000; // Cell capacity when BoardConfig.battCapacityMah is 0
 static constexpr uint16_t IR_AC_REPEAT = 3;           // Number of times to repeat the IR AC frame (improves reliability)
-static constexpr int WEB_SERVER_POLL_INTERVAL_MS = 100; // Interval in ms to poll the web server for OTA updates
+static constexpr int WEB_SERVER_POLL_INTERVAL_MS = 100; // Mains idle loop tick between readings (ms)
+static constexpr int WEB_TASK_POLL_INTERVAL_MS = 10;    // Web server task: poll period for new requests (ms)
+static constexpr uint32_t WEB_TASK_STACK_BYTES = 8192;  // Web server task stack
+static constexpr uint8_t  WEB_TASK_PRIORITY = 1;        // Same as loop(); WiFi/lwIP tasks stay above both
+static constexpr uint16_t WEB_EVENTS_PORT = 81;          // Server-Sent Events stream for the status page
+static constexpr uint8_t  WEB_EVENTS_MAX_CLIENTS = 4;    // Concurrent event subscribers; more get 503 and poll
+static constexpr uint32_t WEB_EVENTS_KEEPALIVE_MS = 15000; // Comment line to idle subscribers (finds dead ones)
+static constexpr uint32_t WEB_EVENTS_HANDSHAKE_MS = 500;  // Time allowed for a subscriber's request head to arrive
+static constexpr uint8_t  WEB_EVENTS_NODE_QUEUE = 4;      // ESP-NOW packets buffered between web task ticks
+static constexpr uint16_t WEB_EVENTS_NODE_JSON_LEN = 160; // Max size of one "node" event
+static constexpr uint16_t HISTORY_SLOTS        = 1440; // Slots per metric in the /history ring (24 h at 1 min)
+static constexpr uint16_t HISTORY_RESOLUTION_S = 60;   // Seconds per history slot
+static constexpr uint8_t  FLASH_HISTORY_FLUSH_RECORDS = 10; // Records buffered in RAM before each flash append
+
+// Idle loop (mains boards, between cycles)
+static constexpr unsigned long IDLE_REPORT_INTERVAL_MS = 3600000UL; // Publish the wake latency summary every hour
+
+// Cycle phase timing metrics
+static constexpr unsigned long METRICS_PUBLISH_INTERVAL_MS = 900000UL; // Mains boards: publish every 15 minutes
+static constexpr int METRICS_PUBLISH_EVERY_WAKES = 12;                  // Battery boards (WiFi path): publish every N wakes
+
+// Wake profiler (battery boards) — current figures used to estimate charge per wake
+static constexpr float WAKE_CURRENT_CPU_MA   = 40.0f;  // CPU awake, radio off (mA)
+static constexpr float WAKE_CURRENT_RADIO_MA = 100.0f; // Extra while the WiFi radio is on (mA)
+static constexpr float WAKE_SLEEP_CURRENT_UA = 10.0f;  // Deep sleep current incl. regulator and sensors (uA)
+static constexpr float WAKE_PROFILE_ALPHA    = 0.2f;   // Weight of the newest wake in the rolling means
 
 // Battery ADC
 static constexpr int   ADC_BIT_WIDTH          = 12;      // 12-bit ADC resolution
-static constexpr int   ADC_SETTLE_DELAY_MS    = 10;      // Settle time between ADC reads (ms)
+static constexpr uint32_t ADC_DEFAULT_VREF_MV = 1100;    // esp_adc_cal fallback when the chip has no eFuse calibration
 static constexpr float VOLT_SMOOTH_NEW        = 0.7f;    // Exponential smoothing weight for new reading
 static constexpr float VOLT_SMOOTH_PREV       = 0.3f;    // Exponential smoothing weight for previous reading
 
@@ -68,21 +113,94 @@ static constexpr int   SCD41_DEFAULT_SCL_PIN  = 22;      // ESP32 default I2C SC
 static constexpr uint8_t SHT40_I2C_ADDR       = 0x44;   // SHT40 default I2C address
 static constexpr int   SCD41_INIT_DELAY_MS    = 500;     // Delay after stopPeriodicMeasurement (ms) — datasheet min 500
 static constexpr int   SCD41_REINIT_DELAY_MS  = 20;      // Delay after reinit() before next command (ms)
+static constexpr uint32_t SCD41_PERIODIC_INTERVAL_MS  =  5000UL; // Standard periodic mode: one sample every 5 s
+static constexpr uint32_t SCD41_LOW_POWER_INTERVAL_MS = 30000UL; // Low-power periodic mode: one sample every 30 s
+static constexpr uint32_t SCD41_SINGLE_SHOT_MS        =  5000UL; // Single-shot measurement duration (datasheet max 5 s)
+static constexpr uint32_t SCD41_READY_MARGIN_MS       =   500UL; // Extra wait beyond the expected sample time before giving up
+static constexpr uint32_t SCD41_READY_POLL_MS         =   100UL; // Data-ready poll period while blocking for a sample
+static constexpr uint32_t SCD41_IDLE_POLL_INTERVAL_MS =  1000UL; // Data-ready poll period in the mains idle loop
+
+// Temperature/humidity fusion across DHT, SHT40 and SCD41
+// SIGMA is each sensor's typical 1σ error (weight = 1/σ²). OFFSET is subtracted
+// from its temperature to cancel self-heating; tune per enclosure.
+static constexpr float FUSION_DHT_TEMP_SIGMA    = 0.5f;  // °C
+static constexpr float FUSION_DHT_HUMID_SIGMA   = 2.0f;  // %RH
+static constexpr float FUSION_DHT_TEMP_OFFSET   = 0.0f;  // °C
+static constexpr float FUSION_SHT40_TEMP_SIGMA  = 0.2f;
+static constexpr float FUSION_SHT40_HUMID_SIGMA = 1.8f;
+static constexpr float FUSION_SHT40_TEMP_OFFSET = 0.0f;
+static constexpr float FUSION_SCD41_TEMP_SIGMA  = 0.8f;
+static constexpr float FUSION_SCD41_HUMID_SIGMA = 6.0f;
+static constexpr float FUSION_SCD41_TEMP_OFFSET = 0.0f;  // on top of the sensor's built-in 4 °C offset
+static constexpr float FUSION_OUTLIER_TEMP_C    = 2.0f;  // Drop a source this far from the others
+static constexpr float FUSION_OUTLIER_HUMID_PCT = 10.0f;
+
+// Adaptive sleep (battery boards with BoardConfig.minSleep/maxSleep)
+static constexpr float SLEEP_ADAPT_TEMP_STEP_C    = 0.2f;  // Resolution steps: aim for about one step of
+static constexpr float SLEEP_ADAPT_HUMID_STEP_PCT = 1.0f;  // change per sample in the fastest-moving reading
+static constexpr float SLEEP_ADAPT_CO2_STEP_PPM   = 50.0f;
+static constexpr float SLEEP_ADAPT_MIN_FACTOR     = 0.5f;  // Largest shortening per wake
+static constexpr float SLEEP_ADAPT_MAX_FACTOR     = 2.0f;  // Largest lengthening per wake
+static constexpr float SLEEP_ADAPT_BATT_FULL_V    = 3.9f;  // At or above: full range allowed
+static constexpr float SLEEP_ADAPT_BATT_LOW_V     = 3.4f;  // At or below: always maxSleep
 
 // PMS5003
 static constexpr int           PMS5003_READ_TIMEOUT_MS  = 2000;    // Timeout waiting for a PMS5003 frame (ms)
 static constexpr unsigned long PMS5003_READ_INTERVAL_MS = 120000UL; // PMS read cycle (ms); independent of main loop
 static constexpr unsigned long PMS5003_WARMUP_MS        =  30000UL; // Warm-up after power-on before stable readings (ms)
+static constexpr int           PMS5003_CMD_SETTLE_MS    = 100;     // Wait after a mode command before requesting a frame (ms)
+// Adaptive read interval: fast while PM2.5 is high or moving, doubling up to
+// the maximum while it is stable. Below PMS5003_STAY_AWAKE_MS the sensor is
+// left running between reads — a sleep that short saves less than a warm-up.
+static constexpr unsigned long PMS5003_MIN_INTERVAL_MS  =  60000UL; // Interval during pollution events (ms)
+static constexpr unsigned long PMS5003_MAX_INTERVAL_MS  = 600000UL; // Interval ceiling in stable air (ms)
+static constexpr unsigned long PMS5003_STAY_AWAKE_MS    =  90000UL; // Keep awake when the next read is sooner than this (ms)
+static constexpr float         PMS5003_ALERT_PM25       = 35.0f;   // PM2.5 at or above this reads fast (µg/m³)
+static constexpr float         PMS5003_FAST_DELTA_UG    = 10.0f;   // PM2.5 change between reads that reads fast (µg/m³)
+static constexpr float         PMS5003_STABLE_DELTA_UG  =  3.0f;   // PM2.5 change at or below this lengthens the interval (µg/m³)
 
 // JSY-MK-194G Modbus
-static constexpr int   JSY_RESPONSE_TIMEOUT_MS = 300;    // Timeout waiting for Modbus response (ms)
-static constexpr int   JSY_RESPONSE_BYTES      = 21;     // Expected Modbus response frame length
-static constexpr float JSY_VOLTAGE_SCALE       = 100.0f; // Raw register → V   (reg × 0.01)
-static constexpr float JSY_CURRENT_SCALE       = 100.0f; // Raw register → A   (reg × 0.01)
-static constexpr float JSY_POWER_SCALE         = 10.0f;  // Raw register → W   (reg × 0.1)
-static constexpr float JSY_PF_SCALE            = 1000.0f;// Raw register → PF  (reg × 0.001)
-static constexpr float JSY_FREQ_SCALE          = 100.0f; // Raw register → Hz  (reg × 0.01)
-static constexpr float JSY_ENERGY_SCALE        = 1000.0f;// Raw Wh → kWh
+static constexpr unsigned long JSY_BAUD_RATE  = 9600;   // Modbus baud — the meter must be configured to match (4800..38400)
+static constexpr unsigned long JSY_SAMPLE_INTERVAL_MS = 1000UL; // Background sample period between publishes (ms)
+static constexpr float JSY_VOLTAGE_SCALE       = 10000.0f; // Raw register → V   (reg × 0.0001)
+static constexpr float JSY_CURRENT_SCALE       = 10000.0f; // Raw register → A   (reg × 0.0001)
+static constexpr float JSY_POWER_SCALE         = 10000.0f; // Raw register → W   (reg × 0.0001)
+static constexpr float JSY_PF_SCALE            = 1000.0f;  // Raw register → PF  (reg × 0.001)
+static constexpr float JSY_FREQ_SCALE          = 100.0f;   // Raw register → Hz  (reg × 0.01)
+static constexpr double JSY_ENERGY_SCALE       = 10000.0;  // Raw register → kWh (reg × 0.0001)
+static constexpr uint8_t JSY_SLAVE_ID          = 0x01;   // Modbus address of the JSY-MK-194G
+// Register map: JSY-MK-194G user manual, Modbus register table (function
+// 0x03, electrical parameters 0x0048–0x0055). Each register address holds
+// one 32-bit value, high word first (JSY_REGISTER_BYTES). Both channels are
+// fetched in one read of JSY_REGISTER_COUNT registers from JSY_REGISTER_START
+// (the manual's frame 01 03 00 48 00 0E, a 0x38-byte reply). The reply is
+// decoded into 16-bit words, two per register; offsets below count words.
+//   0x0048–0x004D  ch1 voltage, current, active power, positive energy, PF, negative energy
+//   0x004E         power direction: high byte ch1, low byte ch2 (1 = negative / exporting)
+//   0x004F         frequency
+//   0x0050–0x0055  ch2 voltage, current, active power, positive energy, PF, negative energy
+static constexpr uint8_t  JSY_CHANNELS          = 2;
+static constexpr uint16_t JSY_REGISTER_START    = 0x0048;
+static constexpr uint8_t  JSY_REGISTER_BYTES    = 4;
+static constexpr uint8_t  JSY_CHANNEL_STRIDE    = 0x10;   // ch2 block at 0x0050 (8 registers on)
+static constexpr uint8_t  JSY_REG_VOLTAGE       = 0;      // ×0.0001 V
+static constexpr uint8_t  JSY_REG_CURRENT       = 2;      // ×0.0001 A
+static constexpr uint8_t  JSY_REG_POWER         = 4;      // ×0.0001 W, magnitude (sign in the direction register)
+static constexpr uint8_t  JSY_REG_ENERGY        = 6;      // positive active energy, ×0.0001 kWh
+static constexpr uint8_t  JSY_REG_PF            = 8;      // ×0.001
+static constexpr uint8_t  JSY_CHANNEL_WORDS     = 12;     // six values per channel block
+static constexpr uint8_t  JSY_REG_DIRECTION     = 0x0C;   // 0x004E
+static constexpr uint8_t  JSY_REG_FREQ          = 0x0E;   // 0x004F, ×0.01 Hz
+static constexpr uint8_t  JSY_WORD_COUNT        = JSY_CHANNEL_STRIDE * (JSY_CHANNELS - 1) + JSY_CHANNEL_WORDS; // to 0x0055
+static constexpr uint8_t  JSY_REGISTER_COUNT    = JSY_WORD_COUNT / (JSY_REGISTER_BYTES / 2); // 0x0E
+
+// Modbus RTU bus (JSY and SENSOR_MODBUS devices share Serial1 and the jsy*Pin wiring)
+static constexpr unsigned long MODBUS_RESPONSE_TIMEOUT_MS = 300UL; // Timeout waiting for a response (ms)
+static constexpr unsigned long MODBUS_POLL_INTERVAL_MS = 5000UL; // One device is polled per interval, round-robin
+static constexpr uint8_t MODBUS_MAX_REGS_PER_READ = 64;  // Largest coalesced read (protocol max 125)
+static constexpr uint8_t MODBUS_MAX_GAP_REGS      = 8;   // Unused registers tolerated inside one coalesced read
+static constexpr uint8_t MODBUS_MAX_REGISTERS     = 32;  // Max registers per device table
+static constexpr uint8_t MODBUS_MAX_DEVICES       = 8;   // Max devices on the bus
 
 // ESP-NOW
 // Read the gateway board's MAC from its serial output on first boot:
@@ -116,6 +234,41 @@ enum SensorType : uint32_t {
     SENSOR_JSY194G = (1 << 3), // JSY-MK-194G AC power meter via Modbus RTU/UART
     SENSOR_IR_AC   = (1 << 4), // IR transmitter — sends commands to Samsung AC unit
     SENSOR_SHT40   = (1 << 5), // SHT40 temperature + humidity via I2C
+    SENSOR_MODBUS  = (1 << 6), // Generic Modbus RTU devices on the RS485 bus (BoardConfig.modbusDevices)
+};
+
+// SCD41 measurement mode, selected per board (BoardConfig.scd41Mode)
+enum Scd41Mode : uint8_t {
+    SCD41_MODE_PERIODIC    = 0, // Standard periodic, new sample every 5 s (~15 mA) — default
+    SCD41_MODE_LOW_POWER   = 1, // Low-power periodic, new sample every 30 s (~3 mA)
+    SCD41_MODE_SINGLE_SHOT = 2, // Idle between on-demand 5 s measurements — use on battery boards
+};
+
+// Generic Modbus RTU device tables (SENSOR_MODBUS)
+// 32-bit types span two registers, high word first.
+enum ModbusDataType : uint8_t {
+    MODBUS_U16,
+    MODBUS_S16,
+    MODBUS_U32,
+    MODBUS_S32,
+    MODBUS_FLOAT32,
+};
+
+struct ModbusRegister {
+    uint16_t       address; // register address (0-based)
+    ModbusDataType type;
+    float          scale;   // published value = raw / scale
+    const char*    topic;   // topic suffix, e.g. "/ac-power/set"
+};
+
+// Registers must be listed in ascending address order; adjacent registers
+// are coalesced into one read.
+struct ModbusDevice {
+    uint8_t               slaveId;
+    uint8_t               function;      // 0x03 holding or 0x04 input registers
+    const char*           name;          // topic segment: home/{room}/{name}{topic}
+    const ModbusRegister* registers;
+    uint8_t               registerCount;
 };
 
 // Allow combining SensorType flags with | in board config initialisers
@@ -123,6 +276,72 @@ inline SensorType operator|(SensorType a, SensorType b) {
     return static_cast<SensorType>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b));
 }
 
+// ── Compile-time board profile (optional) ─────────────────────────────────
+// By default every board runs the same image and getBoardConfig() selects
+// sensors and power mode at runtime. A PlatformIO env can instead pin the
+// board type with build flags (see the profile envs in platformio.ini):
+//   -D BUILD_PROFILE                      enable the profile
+//   -D BUILD_PROFILE_NAME='"name"'        OTA image directory for the profile
+//   -D BUILD_BATTERY  or  -D BUILD_MAINS  power mode
+//   -D BUILD_WITH_DHT, _SHT40, _SCD41, _PMS5003, _JSY194G, _MODBUS, _IR_AC
+//   -D BUILD_WITH_ESPNOW                  ESP-NOW sender (battery) or gateway (mains)
+// Code for anything not built in folds away and is not linked. Board
+// entries must still match the profile; mismatches are reported at boot.
+enum BuildPower : uint8_t {
+    BUILD_POWER_ANY,     // runtime: BoardConfig.isBatteryPowered
+    BUILD_POWER_MAINS,
+    BUILD_POWER_BATTERY,
+};
+
+#ifdef BUILD_PROFILE
+static constexpr uint32_t BUILT_SENSORS = 0
+#ifdef BUILD_WITH_DHT
+    | SENSOR_DHT
+#endif
+#ifdef BUILD_WITH_PMS5003
+    | SENSOR_PMS5003
+#endif
+#ifdef BUILD_WITH_SCD41
+    | SENSOR_SCD41
+#endif
+#ifdef BUILD_WITH_JSY194G
+    | SENSOR_JSY194G
+#endif
+#ifdef BUILD_WITH_IR_AC
+    | SENSOR_IR_AC
+#endif
+#ifdef BUILD_WITH_SHT40
+    | SENSOR_SHT40
+#endif
+#ifdef BUILD_WITH_MODBUS
+    | SENSOR_MODBUS
+#endif
+    ;
+#if defined(BUILD_BATTERY) == defined(BUILD_MAINS)
+#error "BUILD_PROFILE needs exactly one of BUILD_BATTERY or BUILD_MAINS"
+#endif
+#ifdef BUILD_BATTERY
+static constexpr BuildPower BUILT_POWER  = BUILD_POWER_BATTERY;
+#else
+static constexpr BuildPower BUILT_POWER  = BUILD_POWER_MAINS;
+#endif
+#ifdef BUILD_WITH_ESPNOW
+static constexpr bool       BUILT_ESPNOW = true;
+#else
+static constexpr bool       BUILT_ESPNOW = false;
+#endif
+#ifndef BUILD_PROFILE_NAME
+#error "BUILD_PROFILE needs BUILD_PROFILE_NAME (OTA images are fetched per profile)"
+#endif
+// Each profile updates from its own image: https://OTA_HOST/<profile>/sensor/...
+static const char* const OTA_PROFILE_PREFIX = "/" BUILD_PROFILE_NAME;
+#else
+static constexpr uint32_t   BUILT_SENSORS = 0xFFFFFFFFUL;
+static constexpr BuildPower BUILT_POWER   = BUILD_POWER_ANY;
+static constexpr bool       BUILT_ESPNOW  = true;
+static const char* const    OTA_PROFILE_PREFIX = "";
+#endif
+
 struct BoardConfig {
     const char* macAddress;
     const char* roomName;
@@ -140,14 +359,25 @@ struct BoardConfig {
     int8_t   pmsPowerPin;   // PMS5003 power pin    (-1 if unused)
     int8_t   i2cSdaPin;     // SCD41 I2C SDA pin    (-1 = ESP32 default pin 21)
     int8_t   i2cSclPin;     // SCD41 I2C SCL pin    (-1 = ESP32 default pin 22)
-    int8_t   jsyRxPin;      // JSY-MK-194G UART RX  (-1 if unused)
-    int8_t   jsyTxPin;      // JSY-MK-194G UART TX  (-1 if unused)
-    int8_t   jsyDePin;      // JSY-MK-194G RS485 DE/RE direction pin (-1 if unused)
+    int8_t   jsyRxPin;      // JSY-MK-194G / Modbus bus UART RX  (-1 if unused)
+    int8_t   jsyTxPin;      // JSY-MK-194G / Modbus bus UART TX  (-1 if unused)
+    int8_t   jsyDePin;      // JSY-MK-194G / Modbus bus RS485 DE/RE direction pin (-1 if unused)
     // IR AC transmitter
     int8_t   irTxPin;         // GPIO connected to the IR LED (-1 if unused)
     // ESP-NOW
     bool     isEspNowGateway; // true = receive ESP-NOW packets from battery nodes and forward to MQTT
     bool     useEspNow;       // true = transmit sensor data via ESP-NOW instead of direct WiFi+MQTT
+    // SCD41 (fields below may be omitted from initialisers — they default to 0)
+    Scd41Mode scd41Mode;      // SCD41 measurement mode (SCD41_MODE_PERIODIC if omitted)
+    // Generic Modbus devices on the RS485 bus (SENSOR_MODBUS)
+    const ModbusDevice* modbusDevices;
+    uint8_t  modbusDeviceCount;
+    // Battery
+    float    battDividerFactor; // battery voltage divider ratio (0 = BATT_DIVIDER_DEFAULT)
+    // Adaptive sleep (battery boards) — 0 = always sleep timeToSleep
+    uint16_t minSleep;        // shortest sleep (s) while readings change fast
+    uint16_t maxSleep;        // longest sleep (s) in stable conditions or on a low battery
+    uint16_t battCapacityMah; // cell capacity for remaining-life estimates (0 = BATT_CAPACITY_DEFAULT_MAH)
 };
 
 // Board configurations are defined in config.cpp (copy config.cxx and add your boards there)
@@ -0,0 +1,422 @@
+#include "drivers.h"
+#include "fusion.h"
+#include "history.h"
+#include "network.h"
+#include "ota.h"
+#include "sensors.h"
+#include <esp_sleep.h>
+#include <rom/crc.h>
+
+// ── DHT11/DHT22 ───────────────────────────────────────────────────────────
+
+static const MetricDescriptor dhtMetrics[] = {
+    { "T", nullptr, nullptr, nullptr, nullptr, 1, ROLE_TEMPERATURE, -1 },
+    { "H", nullptr, nullptr, nullptr, nullptr, 0, ROLE_HUMIDITY,    -1 },
+};
+
+// No warm path: battery boards cut DHT power between wakes, so the settle
+// guard is always needed.
+static void dhtInit(bool /*warm*/) {
+    dht = new DHT(boardConfig.dhtDataPin, boardConfig.dhtType);
+    powerOnDht(); // settle guard overlaps the other drivers' init
+}
+
+static bool dhtRead(float* values) {
+    SensorData reading = readDhtSensor();
+    values[0] = reading.temperature;
+    values[1] = reading.humidity;
+    return reading.success;
+}
+
+// ── SHT40 ─────────────────────────────────────────────────────────────────
+
+static const MetricDescriptor sht40Metrics[] = {
+    { "T", nullptr, nullptr, nullptr, nullptr, 1, ROLE_TEMPERATURE, -1 },
+    { "H", nullptr, nullptr, nullptr, nullptr, 0, ROLE_HUMIDITY,    -1 },
+};
+
+static void sht40Init(bool /*warm*/) {
+    initSht40(boardConfig.i2cSdaPin, boardConfig.i2cSclPin);
+}
+
+static bool sht40Read(float* values) {
+    SensorData reading = readSht40();
+    values[0] = reading.temperature;
+    values[1] = reading.humidity;
+    return reading.success;
+}
+
+// ── PMS5003 ───────────────────────────────────────────────────────────────
+
+static const MetricDescriptor pmsMetrics[] = {
+    { "PM1",       "PM1.0", "pm1",  "&micro;g/m&#179;", MQTT_PM1_TOPIC,  0, ROLE_PUBLISH, -1 },
+    { "PM2.5",     nullptr, "pm25", "&micro;g/m&#179;", MQTT_PM25_TOPIC, 0, ROLE_PUBLISH, HIST_PM25 },
+    { "PM10",      nullptr, "pm10", "&micro;g/m&#179;", MQTT_PM10_TOPIC, 0, ROLE_PUBLISH, -1 },
+    { "CF1 PM1",   nullptr, nullptr, nullptr, nullptr, 0, ROLE_DEBUG, -1 },
+    { "CF1 PM2.5", nullptr, nullptr, nullptr, nullptr, 0, ROLE_DEBUG, -1 },
+    { "CF1 PM10",  nullptr, nullptr, nullptr, nullptr, 0, ROLE_DEBUG, -1 },
+};
+
+static void pmsInit(bool /*warm*/) {
+    initPms5003();
+}
+
+static void pmsStart() {
+    setPmsPower(true); // laser needs PMS5003_WARMUP_MS before a stable reading
+}
+
+static bool pmsRead(float* values) {
+    Pms5003Data pms = readPms5003();
+    values[0] = pms.pm1;
+    values[1] = pms.pm25;
+    values[2] = pms.pm10;
+    values[3] = pms.pm1Std;
+    values[4] = pms.pm25Std;
+    values[5] = pms.pm10Std;
+    return pms.success;
+}
+
+static uint32_t pmsIntervalMs = PMS5003_READ_INTERVAL_MS;
+static float    pmsLastPm25   = NAN;
+
+// Read fast while PM2.5 is high or moving; double the interval while stable.
+// A failed read falls back to the default interval.
+static uint32_t pmsAdapt(const DriverReading& reading) {
+    uint32_t    next   = PMS5003_READ_INTERVAL_MS;
+    const char* reason = "read failed";
+    if (reading.success) {
+        float pm25  = reading.values[1];
+        float delta = isnan(pmsLastPm25) ? 0.0f : fabsf(pm25 - pmsLastPm25);
+        pmsLastPm25 = pm25;
+        if (pm25 >= PMS5003_ALERT_PM25) {
+            next   = PMS5003_MIN_INTERVAL_MS;
+            reason = "PM2.5 high";
+        } else if (delta >= PMS5003_FAST_DELTA_UG) {
+            next   = PMS5003_MIN_INTERVAL_MS;
+            reason = "PM2.5 changing";
+        } else if (delta <= PMS5003_STABLE_DELTA_UG) {
+            next   = pmsIntervalMs * 2 < PMS5003_MAX_INTERVAL_MS ? pmsIntervalMs * 2 : PMS5003_MAX_INTERVAL_MS;
+            reason = "stable";
+        } else {
+            reason = "moderate change";
+        }
+    }
+    if (next != pmsIntervalMs) {
+        snprintf(debugBuf, sizeof(debugBuf), "PMS5003: read interval %lu s -> %lu s (%s)",
+                 (unsigned long)pmsIntervalMs / 1000UL, (unsigned long)next / 1000UL, reason);
+        debugMessage(debugBuf, false);
+        pmsIntervalMs = next;
+    }
+    return next;
+}
+
+// Runs after pmsAdapt(): a short next interval leaves the sensor running
+static void pmsPowerDown() {
+    if (isBatteryBoard() || pmsIntervalMs < PMS5003_STAY_AWAKE_MS) return;
+    setPmsPower(false);
+}
+
+// ── SCD41 ─────────────────────────────────────────────────────────────────
+
+static const MetricDescriptor scd41Metrics[] = {
+    { "CO2", "CO&#8322;", "co2", "ppm", MQTT_CO2_TOPIC, 0, ROLE_PUBLISH, HIST_CO2 },
+    { "T",   nullptr, nullptr, nullptr, nullptr, 1, ROLE_TEMPERATURE, -1 },
+    { "H",   nullptr, nullptr, nullptr, nullptr, 0, ROLE_HUMIDITY,    -1 },
+};
+
+static void scd41Init(bool warm) {
+    initScd41(boardConfig.i2cSdaPin, boardConfig.i2cSclPin, boardConfig.scd41Mode, warm);
+}
+
+static bool scd41Read(float* values) {
+    Scd41Data scd = readScd41();
+    values[0] = scd.co2;
+    values[1] = scd.temperature;
+    values[2] = scd.humidity;
+    return scd.success;
+}
+
+// ── Driver table ──────────────────────────────────────────────────────────
+// Registry order is read order. SCD41 is last so a single-shot started with
+// the others has had the other reads' time to complete.
+// Drivers outside a compile-time profile (BUILT_SENSORS) become empty
+// entries, so their functions and libraries are not linked.
+
+#define METRICS(m) m, (uint8_t)(sizeof(m) / sizeof(m[0]))
+#define DRIVER(name, measures, flag, ...) \
+    ((BUILT_SENSORS & (flag)) ? SensorDriver{ name, measures, flag, __VA_ARGS__ } : SensorDriver{})
+
+static const SensorDriver driverTable[] = {
+    DRIVER("DHT22", "Temperature &amp; Humidity", SENSOR_DHT, PHASE_DHT_READ, CLIMATE_DHT, true,
+           0, 0, 0,
+           dhtInit, nullptr, nullptr, dhtRead, powerOffDht, nullptr, METRICS(dhtMetrics)),
+    DRIVER("SHT40", "Temperature &amp; Humidity", SENSOR_SHT40, PHASE_SHT40_READ, CLIMATE_SHT40, true,
+           0, 0, 0,
+           sht40Init, nullptr, nullptr, sht40Read, nullptr, nullptr, METRICS(sht40Metrics)),
+    DRIVER("PMS5003", "PM1.0 / PM2.5 / PM10", SENSOR_PMS5003, PHASE_PMS_READ, -1, false,
+           PMS5003_READ_INTERVAL_MS, PMS5003_WARMUP_MS, 0,
+           pmsInit, pmsStart, nullptr, pmsRead, pmsPowerDown, pmsAdapt, METRICS(pmsMetrics)),
+    DRIVER("SCD41", "CO&#8322; / Temperature / Humidity", SENSOR_SCD41, PHASE_SCD41_READ, CLIMATE_SCD41, false,
+           0, SCD41_SINGLE_SHOT_MS, SCD41_IDLE_POLL_INTERVAL_MS,
+           scd41Init, startScd41Measurement, pollScd41, scd41Read, nullptr, nullptr, METRICS(scd41Metrics)),
+};
+
+#undef DRIVER
+#undef METRICS
+
+static constexpr uint8_t DRIVER_MAX = sizeof(driverTable) / sizeof(driverTable[0]);
+
+struct DriverState {
+    bool          started;
+    uint32_t      intervalMs;  // from adapt(), else the driver's intervalMs
+    unsigned long lastReadMs;
+    unsigned long lastPollMs;
+    DriverReading last;
+    uint32_t      reads;       // successful reads since boot
+    uint32_t      failures;    // failed reads since boot
+    char          topics[DRIVER_MAX_METRICS][TOPIC_BUF_LEN]; // ROLE_PUBLISH metrics only
+};
+
+static const SensorDriver* registry[DRIVER_MAX];
+static DriverState         state[DRIVER_MAX];
+static uint8_t             registered = 0;
+
+// ── Warm wake ─────────────────────────────────────────────────────────────
+// Written to RTC memory after every init. A timer wake finding a block with
+// the current version, a good CRC and the same drivers and wiring inits warm.
+
+static constexpr uint16_t SENSOR_STATE_VERSION = 1;
+
+struct SensorStateBlock {
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t sensors;     // SENSOR_* bits of the registered drivers
+    uint32_t fingerprint; // CRC of the board fields the drivers were set up with
+    uint32_t crc;         // over the fields above
+};
+
+RTC_DATA_ATTR static SensorStateBlock sensorState;
+RTC_DATA_ATTR static uint32_t         coldBoots = 0;
+RTC_DATA_ATTR static uint32_t         warmBoots = 0;
+static bool                           warmBoot  = false;
+
+static uint32_t boardFingerprint() {
+    const int8_t fields[] = {
+        boardConfig.i2cSdaPin, boardConfig.i2cSclPin, (int8_t)boardConfig.scd41Mode,
+        boardConfig.dhtDataPin, (int8_t)boardConfig.dhtType, boardConfig.pmsRxPin, boardConfig.pmsTxPin,
+    };
+    return crc32_le(0, (const uint8_t*)fields, sizeof(fields));
+}
+
+static uint32_t stateCrc(const SensorStateBlock& s) {
+    return crc32_le(0, (const uint8_t*)&s, offsetof(SensorStateBlock, crc));
+}
+
+static uint32_t registeredSensors() {
+    uint32_t sensors = 0;
+    for (uint8_t i = 0; i < registered; i++) sensors |= registry[i]->sensorFlag;
+    return sensors;
+}
+
+static bool sensorStateValid() {
+    return esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER &&
+           sensorState.version == SENSOR_STATE_VERSION &&
+           sensorState.crc == stateCrc(sensorState) &&
+           sensorState.sensors == registeredSensors() &&
+           sensorState.fingerprint == boardFingerprint();
+}
+
+static void saveSensorState() {
+    sensorState             = {};
+    sensorState.version     = SENSOR_STATE_VERSION;
+    sensorState.sensors     = registeredSensors();
+    sensorState.fingerprint = boardFingerprint();
+    sensorState.crc         = stateCrc(sensorState);
+}
+
+bool driversWarmBoot() {
+    return warmBoot;
+}
+
+void driversBootCounts(uint32_t& cold, uint32_t& warm) {
+    cold = coldBoots;
+    warm = warmBoots;
+}
+
+// ── Registry ──────────────────────────────────────────────────────────────
+
+void initDrivers() {
+    registered = 0;
+    for (uint8_t t = 0; t < DRIVER_MAX; t++) {
+        const SensorDriver& d = driverTable[t];
+        if (!d.read || !hasSensor(d.sensorFlag)) continue;
+        DriverState& st = state[registered];
+        st = {};
+        for (uint8_t m = 0; m < d.metricCount; m++) {
+            st.last.values[m] = NAN;
+            if (d.metrics[m].role != ROLE_PUBLISH) continue;
+            snprintf(st.topics[m], TOPIC_BUF_LEN, "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName,
+                     d.metrics[m].topicSuffix);
+        }
+        registry[registered++] = &d;
+    }
+
+    warmBoot = sensorStateValid();
+    if (warmBoot) warmBoots++;
+    else          coldBoots++;
+    for (uint8_t i = 0; i < registered; i++) {
+        if (registry[i]->init) registry[i]->init(warmBoot);
+    }
+    saveSensorState();
+    Serial.printf("Sensors: %s boot (cold %lu, warm %lu)\n", warmBoot ? "warm" : "cold",
+                  (unsigned long)coldBoots, (unsigned long)warmBoots);
+    // All measurements start before any read. First interval-limited read is
+    // due once the start lead (warm-up) has passed.
+    for (uint8_t i = 0; i < registered; i++) {
+        const SensorDriver& d = *registry[i];
+        if (d.start) d.start();
+        state[i].started    = true;
+        state[i].intervalMs = d.intervalMs;
+        state[i].lastReadMs = millis() - d.intervalMs + d.startLeadMs;
+    }
+}
+
+uint8_t driverCount() {
+    return registered;
+}
+
+const SensorDriver& driverAt(uint8_t i) {
+    return *registry[i < registered ? i : 0];
+}
+
+DriverReading driverLastReading(uint8_t i) {
+    WebStateGuard guard; // web handlers copy it while loop() may be storing a read
+    return state[i < registered ? i : 0].last;
+}
+
+void driverReadStats(uint8_t i, uint32_t& ok, uint32_t& failed) {
+    const DriverState& st = state[i < registered ? i : 0];
+    ok     = st.reads;
+    failed = st.failures;
+}
+
+bool driverDue(uint8_t i) {
+    const DriverState& st = state[i];
+    return st.intervalMs == 0 || millis() - st.lastReadMs >= st.intervalMs;
+}
+
+uint32_t driverIntervalMs(uint8_t i) {
+    return state[i < registered ? i : 0].intervalMs;
+}
+
+// Read one driver, record its latency and pass T/H to fusion. The interval
+// restarts on every attempt, successful or not.
+bool driverRead(uint8_t i, DriverReading& out) {
+    const SensorDriver& d = *registry[i];
+    DriverState& st = state[i];
+    for (uint8_t m = 0; m < DRIVER_MAX_METRICS; m++) out.values[m] = NAN;
+
+    unsigned long t0 = millis();
+    out.success = d.read(out.values);
+    metricsRecord(d.phase, millis() - t0);
+    st.lastReadMs = millis();
+    st.started    = false;
+    if (d.adapt) st.intervalMs = d.adapt(out);
+    if (d.powerDown) d.powerDown();
+    if (!out.success) {
+        st.failures++;
+        return false;
+    }
+    st.reads++;
+
+    {
+        WebStateGuard guard;
+        st.last = out;
+        webDataChanged();
+    }
+    if (d.climate >= 0) {
+        float temperature = NAN;
+        float humidity    = NAN;
+        for (uint8_t m = 0; m < d.metricCount; m++) {
+            if (d.metrics[m].role == ROLE_TEMPERATURE) temperature = out.values[m];
+            if (d.metrics[m].role == ROLE_HUMIDITY)    humidity    = out.values[m];
+        }
+        fusionAdd((ClimateSource)d.climate, temperature, humidity);
+        successCount++;
+    }
+    return true;
+}
+
+// Publish a successful reading's own metrics, record history and send one
+// debug line. Drivers that only supply fused T/H publish nothing here.
+void driverPublish(uint8_t i, const DriverReading& reading, const char* timeStr) {
+    const SensorDriver& d = *registry[i];
+    bool published = false;
+    for (uint8_t m = 0; m < d.metricCount; m++) {
+        const MetricDescriptor& md = d.metrics[m];
+        if (md.history >= 0) historyRecord((HistoryMetric)md.history, reading.values[m]);
+        if (md.role != ROLE_PUBLISH) continue;
+        mqttSendFloat(state[i].topics[m], reading.values[m]);
+        published = true;
+    }
+    if (!published) return;
+
+    int len = snprintf(debugBuf, sizeof(debugBuf), "%s", timeStr);
+    for (uint8_t m = 0; m < d.metricCount && len < (int)sizeof(debugBuf); m++) {
+        len += snprintf(debugBuf + len, sizeof(debugBuf) - len, " | %s: %.*f",
+                        d.metrics[m].label, d.metrics[m].decimals, reading.values[m]);
+    }
+    debugMessage(debugBuf, false);
+}
+
+// Mains idle loop: re-start each driver startLeadMs before its next read is
+// due (the next cycle, or its own interval), and poll for data ready.
+void driversIdleTick(unsigned long nextCycleMs) {
+    for (uint8_t i = 0; i < registered; i++) {
+        const SensorDriver& d = *registry[i];
+        DriverState& st = state[i];
+        if (d.start && !st.started) {
+            unsigned long dueMs = st.intervalMs ? st.lastReadMs + st.intervalMs : nextCycleMs;
+            if ((long)(millis() - (dueMs - d.startLeadMs)) >= 0) {
+                d.start();
+                st.started = true;
+            }
+        }
+        if (d.poll && millis() - st.lastPollMs >= d.pollIntervalMs) {
+            d.poll();
+            st.lastPollMs = millis();
+        }
+    }
+}
+
+bool driversHaveClimate() {
+    for (uint8_t i = 0; i < registered; i++) {
+        if (registry[i]->climate >= 0) return true;
+    }
+    return false;
+}
+
+static bool findMetric(const char* key, uint8_t& driver, uint8_t& metric) {
+    for (uint8_t i = 0; i < registered; i++) {
+        for (uint8_t m = 0; m < registry[i]->metricCount; m++) {
+            const char* k = registry[i]->metrics[m].key;
+            if (k && strcmp(k, key) == 0) {
+                driver = i;
+                metric = m;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+float driverValue(const char* key) {
+    uint8_t i, m;
+    if (!findMetric(key, i, m) || !state[i].last.success) return NAN;
+    return state[i].last.values[m];
+}
+
+const char* driverTopic(const char* key) {
+    uint8_t i, m;
+    return findMetric(key, i, m) ? state[i].topics[m] : nullptr;
+}
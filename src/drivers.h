@@ -0,0 +1,92 @@
+#ifndef DRIVERS_H
+#define DRIVERS_H
+
+#include "globals.h"
+#include "metrics.h"
+
+// ── Sensor driver registry ────────────────────────────────────────────────
+// Each measuring sensor is a SensorDriver: lifecycle hooks plus descriptors
+// for the values it produces. initDrivers() keeps the drivers whose SENSOR_*
+// bit is set in boardConfig.sensors, builds their topics, runs init() and
+// then start() on every one of them, so all measurements are under way
+// before the first read. The core loop only iterates over that registry.
+//
+// Cycle per driver:
+//   init(warm)  once per boot. warm = timer wake from deep sleep with a valid
+//               sensor-state block: the sensor kept power and settings, so
+//               its reset/configure sequence can be skipped.
+//   start()     begin a measurement / power up (optional). Mains boards
+//               re-issue it startLeadMs before the next read is due.
+//   poll()      non-blocking data-ready check from the idle loop (optional)
+//   read()      blocking read into values[], in descriptor order
+//   adapt()     after every read attempt: returns the interval until the
+//               next read (optional; default intervalMs)
+//   powerDown() after every read attempt (optional)
+//
+// Adding a sensor: a SENSOR_* bit in config.h, its hardware functions in
+// sensors.cpp, and a descriptor table plus SensorDriver entry in drivers.cpp.
+// JSY-MK-194G and generic Modbus devices are not drivers: they sample in the
+// background (jsy_sampler, modbus) and publish on their own schedule.
+
+enum MetricRole : uint8_t {
+    ROLE_PUBLISH,     // own MQTT topic, status page row and /data key
+    ROLE_TEMPERATURE, // fused with the other sources (fusion.h), published once
+    ROLE_HUMIDITY,
+    ROLE_DEBUG,       // debug line only
+};
+
+struct MetricDescriptor {
+    const char* label;       // debug line label
+    const char* webLabel;    // status page label (HTML); nullptr = label
+    const char* key;         // /data key and status page element id (ROLE_PUBLISH)
+    const char* unit;        // status page unit (HTML)
+    const char* topicSuffix; // MQTT topic suffix (ROLE_PUBLISH)
+    uint8_t     decimals;
+    MetricRole  role;
+    int8_t      history;     // HistoryMetric to record, or -1
+};
+
+static constexpr uint8_t DRIVER_MAX_METRICS = 6;
+
+struct DriverReading {
+    float values[DRIVER_MAX_METRICS];
+    bool  success;
+};
+
+struct SensorDriver {
+    const char* name;          // "SCD41"
+    const char* measures;      // status page description (HTML)
+    uint8_t     sensorFlag;    // SENSOR_* bit that enables the driver
+    CyclePhase  phase;         // read latency metric
+    int8_t      climate;       // ClimateSource for ROLE_TEMPERATURE/HUMIDITY, or -1
+    bool        required;      // failed read ends a battery wake early
+    uint32_t    intervalMs;    // minimum time between reads; 0 = every cycle
+    uint32_t    startLeadMs;   // mains: start() this long before the read is due
+    uint32_t    pollIntervalMs;
+    void (*init)(bool warm);
+    void (*start)();
+    bool (*poll)();
+    bool (*read)(float* values);
+    void (*powerDown)();
+    uint32_t (*adapt)(const DriverReading& reading);
+    const MetricDescriptor* metrics;
+    uint8_t     metricCount;
+};
+
+void                  initDrivers();
+uint8_t               driverCount();
+const SensorDriver&   driverAt(uint8_t i);
+DriverReading         driverLastReading(uint8_t i);
+void                  driverReadStats(uint8_t i, uint32_t& ok, uint32_t& failed); // since boot
+bool                  driverDue(uint8_t i);
+uint32_t              driverIntervalMs(uint8_t i); // current read interval; 0 = every cycle
+bool                  driverRead(uint8_t i, DriverReading& out);
+void                  driverPublish(uint8_t i, const DriverReading& reading, const char* timeStr);
+void                  driversIdleTick(unsigned long nextCycleMs);
+bool                  driversHaveClimate();
+bool                  driversWarmBoot();
+void                  driversBootCounts(uint32_t& cold, uint32_t& warm); // since power-on
+float                 driverValue(const char* key);  // latest ROLE_PUBLISH value, NAN if none
+const char*           driverTopic(const char* key);  // nullptr if no such metric
+
+#endif // DRIVERS_H
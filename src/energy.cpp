@@ -0,0 +1,79 @@
+#include "energy.h"
+#include "network.h"
+#include <Preferences.h>
+
+static const char* const ENERGY_NVS_NAMESPACE = "energy";
+static const char* const ENERGY_NVS_KEY       = "rollup";
+static constexpr uint16_t ENERGY_STATE_VERSION = 1;
+
+enum EnergyPeriod : uint8_t { PERIOD_HOUR, PERIOD_DAY, PERIOD_MONTH, PERIOD_COUNT };
+
+struct RollupState {
+    uint16_t version;
+    uint32_t key[PERIOD_COUNT];      // period identifier, 0 = none yet
+    double   startKwh[PERIOD_COUNT]; // meter reading at the start of the period
+};
+
+static RollupState state  = {};
+static bool        loaded = false;
+
+static void loadState() {
+    loaded = true;
+    Preferences prefs;
+    if (!prefs.begin(ENERGY_NVS_NAMESPACE, true)) return;
+    RollupState stored;
+    if (prefs.getBytesLength(ENERGY_NVS_KEY) == sizeof(stored) &&
+            prefs.getBytes(ENERGY_NVS_KEY, &stored, sizeof(stored)) == sizeof(stored) &&
+            stored.version == ENERGY_STATE_VERSION) {
+        state = stored;
+        Serial.println("Energy: restored rollup start readings from NVS");
+    }
+    prefs.end();
+}
+
+static void saveState() {
+    Preferences prefs;
+    if (!prefs.begin(ENERGY_NVS_NAMESPACE, false)) {
+        debugMessage("Energy: NVS open failed, rollups not saved", false);
+        return;
+    }
+    state.version = ENERGY_STATE_VERSION;
+    prefs.putBytes(ENERGY_NVS_KEY, &state, sizeof(state));
+    prefs.end();
+}
+
+void energyRollupUpdate(double meterKwh, const struct tm& now, EnergyTotals& out) {
+    if (!loaded) loadState();
+
+    // +1 keeps every key non-zero so 0 can mean "no period yet"
+    const uint32_t dayIndex = (uint32_t)now.tm_year * 366 + now.tm_yday;
+    const uint32_t keys[PERIOD_COUNT] = {
+        dayIndex * 24 + now.tm_hour + 1,
+        dayIndex + 1,
+        (uint32_t)now.tm_year * 12 + now.tm_mon + 1,
+    };
+    const char* const completedTopics[PERIOD_COUNT] = {
+        jsyLastHourEnergyTopic, jsyYesterdayEnergyTopic, jsyLastMonthEnergyTopic,
+    };
+
+    bool dirty = false;
+    for (uint8_t p = 0; p < PERIOD_COUNT; p++) {
+        if (state.key[p] != keys[p]) {
+            if (state.key[p] != 0) {
+                double kwh = meterKwh - state.startKwh[p];
+                mqttSendFloat(completedTopics[p], kwh > 0.0 ? (float)kwh : 0.0f, true);
+            }
+            state.key[p]      = keys[p];
+            state.startKwh[p] = meterKwh;
+            dirty = true;
+        } else if (meterKwh < state.startKwh[p]) {
+            state.startKwh[p] = meterKwh; // meter reset/rollover — restart the period
+            dirty = true;
+        }
+    }
+    if (dirty) saveState();
+
+    out.hourKwh  = meterKwh - state.startKwh[PERIOD_HOUR];
+    out.dayKwh   = meterKwh - state.startKwh[PERIOD_DAY];
+    out.monthKwh = meterKwh - state.startKwh[PERIOD_MONTH];
+}
@@ -0,0 +1,25 @@
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#include "globals.h"
+
+// ── Energy rollups (JSY channel 1) ────────────────────────────────────────
+// energyRollupUpdate() takes the meter's cumulative kWh and the local time
+// at each publish. It tracks the meter reading at the start of the current
+// hour, day and month. When a boundary passes, the finished bucket is
+// published (retained) and the new start readings are saved to NVS.
+//
+// All three start readings share one NVS blob. It is written only when a
+// boundary passes or the meter resets, so at most about once an hour. After a
+// reboot the running totals resume from the saved readings instead of zero.
+// Energy used while the board was off lands in the bucket that was open.
+
+struct EnergyTotals {
+    float hourKwh;  // running totals for the current period
+    float dayKwh;
+    float monthKwh;
+};
+
+void energyRollupUpdate(double meterKwh, const struct tm& now, EnergyTotals& out);
+
+#endif // ENERGY_H
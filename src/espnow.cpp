@@ -1,6 +1,9 @@
 #include "espnow.h"
 #include "globals.h"
+#include "metrics.h"
 #include "network.h"
+#include "sleep_adapt.h"
+#include "web_events.h"
 #include <esp_now.h>
 #include <esp_wifi.h>
 #include <WiFi.h>
@@ -18,17 +21,51 @@ static EspNowPayload espNowRxBuf     = {};
 static uint32_t lastRxMs         = 0;
 static volatile bool reinitRequested = false;
 
+// Counters: the rx ones are written by the WiFi task only
+static volatile uint32_t rxReceived = 0;
+static volatile uint32_t rxRejected = 0;
+static volatile uint32_t rxDropped  = 0;
+static uint32_t          rxReinits  = 0;
+
 // Runs in the WiFi task context — keep it short; just copy and set flag.
+// Unversioned packets from older nodes have no version byte and may be
+// shorter; fields they lack are left unavailable.
 static void onDataReceived(const uint8_t* mac, const uint8_t* data, int len) {
-    if ((size_t)len != sizeof(EspNowPayload)) return;
-    memcpy((void*)&espNowRxBuf, data, sizeof(EspNowPayload));
+    if (len < 1) {
+        rxRejected++;
+        return;
+    }
+    bool versioned = data[0] != 0 && data[0] < ESPNOW_PAYLOAD_VERSION_LIMIT;
+    bool valid = versioned
+        ? data[0] == ESPNOW_PAYLOAD_VERSION && (size_t)len == sizeof(EspNowPayload)
+        : (size_t)len >= ESPNOW_LEGACY_MIN_LEN && (size_t)len <= ESPNOW_LEGACY_MAX_LEN;
+    if (!valid) {
+        rxRejected++;
+        return;
+    }
+    if (espNowDataReady) rxDropped++;
+    rxReceived++;
+    EspNowPayload pkt = {};
+    pkt.co2         = NAN;
+    pkt.batterySoc  = ESPNOW_BATTERY_SOC_NONE;
+    pkt.batteryDays = ESPNOW_BATTERY_DAYS_NONE;
+    if (versioned) memcpy(&pkt, data, len);
+    else           memcpy(pkt.roomName, data, len);  // version stays 0
+    memcpy((void*)&espNowRxBuf, &pkt, sizeof(EspNowPayload));
     espNowDataReady = true;
 }
 
+// JSON number, or null when unavailable
+static void jsonNumber(char* buf, size_t len, float value, uint8_t decimals) {
+    if (isnan(value)) snprintf(buf, len, "null");
+    else              snprintf(buf, len, "%.*f", decimals, value);
+}
+
 // Tear down and bring the ESP-NOW receiver back up. Called after WiFi events
 // that may have desynced the ESP-NOW driver, or when the RX watchdog expires.
 // Runs on the main task so it is safe to call esp_now_deinit/init here.
 static void reinitEspNowReceiver() {
+    rxReinits++;
     esp_now_deinit();
     if (esp_now_init() != ESP_OK) {
         Serial.println("ESP-NOW: gateway re-init failed");
@@ -84,6 +121,10 @@ void espNowGatewayTick() {
     }
 }
 
+EspNowGatewayStats espNowGatewayStats() {
+    return {rxReceived, rxRejected, rxDropped, rxReinits};
+}
+
 void handleEspNowReceived() {
     if (!espNowDataReady) return;
 
@@ -107,6 +148,22 @@ void handleEspNowReceived() {
         snprintf(topic, sizeof(topic), "%s%s%s", MQTT_TOPIC_USER, pkt.roomName, MQTT_BATTERY_TOPIC);
         mqttSendFloat(topic, pkt.batteryVolts);
     }
+    if (pkt.batterySoc != ESPNOW_BATTERY_SOC_NONE) {
+        snprintf(topic, sizeof(topic), "%s%s%s", MQTT_TOPIC_USER, pkt.roomName, MQTT_BATTERY_SOC_TOPIC);
+        mqttSendFloat(topic, pkt.batterySoc);
+    }
+    if (pkt.batteryDays != ESPNOW_BATTERY_DAYS_NONE) {
+        snprintf(topic, sizeof(topic), "%s%s%s", MQTT_TOPIC_USER, pkt.roomName, MQTT_BATTERY_DAYS_TOPIC);
+        mqttSendFloat(topic, pkt.batteryDays);
+    }
+    if (!isnan(pkt.co2)) {
+        snprintf(topic, sizeof(topic), "%s%s%s", MQTT_TOPIC_USER, pkt.roomName, MQTT_CO2_TOPIC);
+        mqttSendFloat(topic, pkt.co2);
+    }
+    if (pkt.sleepS > 0) {
+        snprintf(topic, sizeof(topic), "%s%s%s", MQTT_TOPIC_USER, pkt.roomName, MQTT_SLEEP_TOPIC);
+        mqttSendFloat(topic, pkt.sleepS);
+    }
 
     // Debug message published to the remote node's own debug topic
     // Add a timestamp (local time) so the retained debug message shows when
@@ -122,15 +179,38 @@ void handleEspNowReceived() {
         tsBuf[sizeof(tsBuf) - 1] = '\0';
     }
 
+    char socStr[4]  = "-";
+    char daysStr[6] = "-";
+    if (pkt.batterySoc != ESPNOW_BATTERY_SOC_NONE)   snprintf(socStr,  sizeof(socStr),  "%u", pkt.batterySoc);
+    if (pkt.batteryDays != ESPNOW_BATTERY_DAYS_NONE) snprintf(daysStr, sizeof(daysStr), "%u", pkt.batteryDays);
+
     snprintf(debugBuf, sizeof(debugBuf),
-             "%s | V%s | ESP-NOW [%s] T:%.1f H:%.0f%% Bat:%.2fV Boot:%u Success:%u GwCh:%u",
+             "%s | V%s | ESP-NOW [%s] T:%.1f H:%.0f%% CO2:%.0f Bat:%.2fV %s%% %sd Boot:%u Success:%u Awake:%ums %uuAh Sleep:%us (%s) GwCh:%u",
              tsBuf,
              FIRMWARE_VERSION,
-             pkt.roomName, pkt.temperature, pkt.humidity,
-             pkt.batteryVolts, pkt.bootCount, pkt.successCount,
+             pkt.roomName, pkt.temperature, pkt.humidity, pkt.co2,
+             pkt.batteryVolts, socStr, daysStr, pkt.bootCount, pkt.successCount, pkt.awakeMs, pkt.wakeUah,
+             pkt.sleepS, sleepReasonName((SleepReason)pkt.sleepReason),
              (unsigned)WiFi.channel());
     Serial.println(debugBuf);
 
+    // Live "node" event for status page subscribers
+    char t[12], h[12], co2[12], bat[12];
+    jsonNumber(t,   sizeof(t),   pkt.temperature, 1);
+    jsonNumber(h,   sizeof(h),   pkt.humidity, 0);
+    jsonNumber(co2, sizeof(co2), pkt.co2, 0);
+    jsonNumber(bat, sizeof(bat), pkt.batteryVolts > 0.0f ? pkt.batteryVolts : NAN, 2);
+    char room[sizeof(pkt.roomName)];
+    for (size_t i = 0; i < sizeof(room); i++) { // the name comes off the air: keep the JSON valid
+        char c  = pkt.roomName[i];
+        room[i] = (c == '"' || c == '\\' || (c > 0 && c < ' ')) ? '_' : c;
+    }
+    char nodeJson[WEB_EVENTS_NODE_JSON_LEN];
+    snprintf(nodeJson, sizeof(nodeJson),
+             "{\"room\":\"%s\",\"time\":\"%s\",\"t\":%s,\"h\":%s,\"co2\":%s,\"bat\":%s,\"soc\":%s}",
+             room, tsBuf, t, h, co2, bat, pkt.batterySoc != ESPNOW_BATTERY_SOC_NONE ? socStr : "null");
+    webPushNode(nodeJson);
+
     char dbgTopic[TOPIC_BUF_LEN];
     snprintf(dbgTopic, sizeof(dbgTopic), "%s%s%s", MQTT_TOPIC_USER, pkt.roomName, MQTT_DEBUG_TOPIC);
     mqttClient.beginMessage(dbgTopic, /*retain=*/true);
@@ -149,6 +229,7 @@ static void onDataSent(const uint8_t* mac, esp_now_send_status_t status) {
 }
 
 bool espNowSend(const EspNowPayload& payload, uint8_t channel) {
+    wakeProfileRadio(true);
     WiFi.mode(WIFI_STA);
     WiFi.disconnect();
     delay(100);
@@ -1,19 +1,48 @@
 #ifndef ESPNOW_H
 #define ESPNOW_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 // Payload transmitted by a battery node to the ESP-NOW gateway.
 // All sensor fields are present in every packet; NAN signals "not available".
+//
+// The first byte is the layout version. Nodes built before it existed send
+// the same fields without it, so their packets start with the room name;
+// versions stay below ESPNOW_PAYLOAD_VERSION_LIMIT, which no room name starts
+// with, and the gateway tells the two apart by that byte. Bump
+// ESPNOW_PAYLOAD_VERSION on any layout change; gateways reject versions they
+// do not know, so update gateways before senders.
 struct __attribute__((packed)) EspNowPayload {
+    uint8_t  version;        // ESPNOW_PAYLOAD_VERSION (0 for unversioned packets)
     char     roomName[16];   // BoardConfig.roomName, null-terminated
     float    temperature;    // °C  (NAN if unavailable)
     float    humidity;       // %RH (NAN if unavailable)
     float    batteryVolts;   // V   (0.0 if unavailable)
     uint16_t bootCount;
     uint16_t successCount;
+    // Fields below were appended after the first release. The gateway accepts
+    // shorter unversioned packets and treats missing fields as unavailable.
+    float    co2;            // ppm (NAN if unavailable)
+    uint16_t awakeMs;        // previous wake's awake time (0 if unavailable)
+    uint16_t wakeUah;        // rolling mean charge per wake, µAh (0 if unavailable)
+    uint16_t sleepS;         // next sleep interval, s (0 if unavailable)
+    uint8_t  sleepReason;    // SleepReason for sleepS
+    uint8_t  batterySoc;     // state of charge, % (ESPNOW_BATTERY_SOC_NONE if unavailable)
+    uint16_t batteryDays;    // projected remaining life, days (ESPNOW_BATTERY_DAYS_NONE if unavailable)
 };
 
+static constexpr uint8_t  ESPNOW_BATTERY_SOC_NONE  = 0xFF;
+static constexpr uint16_t ESPNOW_BATTERY_DAYS_NONE = 0xFFFF;
+
+static constexpr uint8_t ESPNOW_PAYLOAD_VERSION       = 1;
+static constexpr uint8_t ESPNOW_PAYLOAD_VERSION_LIMIT = 0x20;  // below ASCII space
+
+// Unversioned packets: from the original payload (before co2 was appended)
+// up to the last field, all without the version byte.
+static constexpr size_t ESPNOW_LEGACY_MIN_LEN = offsetof(EspNowPayload, co2) - offsetof(EspNowPayload, roomName);
+static constexpr size_t ESPNOW_LEGACY_MAX_LEN = sizeof(EspNowPayload) - offsetof(EspNowPayload, roomName);
+
 // ── Gateway (receiver) ────────────────────────────────────────────────────
 // Call initEspNowGateway() once after WiFi is connected.
 // Call handleEspNowReceived() regularly from loop() to forward received
@@ -24,6 +53,15 @@ void initEspNowGateway();
 void handleEspNowReceived();
 void espNowGatewayTick();
 
+// Gateway counters since boot, for /metrics
+struct EspNowGatewayStats {
+    uint32_t received; // packets accepted by the receive callback
+    uint32_t rejected; // wrong length or unknown version
+    uint32_t dropped;  // overwritten before loop() forwarded them
+    uint32_t reinits;  // receiver re-initialised (WiFi reconnect or RX watchdog)
+};
+EspNowGatewayStats espNowGatewayStats();
+
 // ── Battery node (sender) ─────────────────────────────────────────────────
 // Configures WiFi to the given channel, sends the payload to
 // ESPNOW_GATEWAY_MAC, and blocks until an ACK arrives or
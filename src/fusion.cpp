@@ -0,0 +1,101 @@
+#include "fusion.h"
+
+struct SourceModel {
+    const char* name;
+    float       tempSigma;
+    float       humidSigma;
+    float       tempOffset;
+};
+
+static const SourceModel models[CLIMATE_SOURCE_COUNT] = {
+    {"DHT",   FUSION_DHT_TEMP_SIGMA,   FUSION_DHT_HUMID_SIGMA,   FUSION_DHT_TEMP_OFFSET},
+    {"SHT40", FUSION_SHT40_TEMP_SIGMA, FUSION_SHT40_HUMID_SIGMA, FUSION_SHT40_TEMP_OFFSET},
+    {"SCD41", FUSION_SCD41_TEMP_SIGMA, FUSION_SCD41_HUMID_SIGMA, FUSION_SCD41_TEMP_OFFSET},
+};
+
+static float   temps[CLIMATE_SOURCE_COUNT];
+static float   humids[CLIMATE_SOURCE_COUNT];
+static uint8_t present = 0;
+
+// Saturation vapour pressure over water (Magnus, hPa)
+static float saturationPressure(float t) {
+    return 6.112f * expf(17.62f * t / (243.12f + t));
+}
+
+void fusionReset() {
+    present = 0;
+}
+
+void fusionAdd(ClimateSource source, float temperature, float humidity) {
+    if (source >= CLIMATE_SOURCE_COUNT || isnan(temperature) || isnan(humidity)) return;
+    const float t = temperature - models[source].tempOffset;
+    // Same absolute humidity, expressed at the corrected temperature
+    float h = humidity * saturationPressure(temperature) / saturationPressure(t);
+    if (h > 100.0f) h = 100.0f;
+    temps[source]  = t;
+    humids[source] = h;
+    present |= (1 << source);
+}
+
+static float median(float* v, uint8_t n) {
+    for (uint8_t i = 1; i < n; i++) {
+        for (uint8_t j = i; j > 0 && v[j] < v[j - 1]; j--) {
+            float tmp = v[j]; v[j] = v[j - 1]; v[j - 1] = tmp;
+        }
+    }
+    return (n % 2) ? v[n / 2] : 0.5f * (v[n / 2 - 1] + v[n / 2]);
+}
+
+FusedClimate fusionResult() {
+    FusedClimate out = {NAN, NAN, 0, 0, false};
+    uint8_t n = 0;
+    float   t[CLIMATE_SOURCE_COUNT], h[CLIMATE_SOURCE_COUNT];
+    for (uint8_t s = 0; s < CLIMATE_SOURCE_COUNT; s++) {
+        if (!(present & (1 << s))) continue;
+        t[n] = temps[s];
+        h[n] = humids[s];
+        n++;
+    }
+    if (n == 0) return out;
+
+    uint8_t used = present;
+    if (n >= 3) {
+        const float tMed = median(t, n);
+        const float hMed = median(h, n);
+        for (uint8_t s = 0; s < CLIMATE_SOURCE_COUNT; s++) {
+            if (!(present & (1 << s))) continue;
+            if (fabsf(temps[s] - tMed) > FUSION_OUTLIER_TEMP_C || fabsf(humids[s] - hMed) > FUSION_OUTLIER_HUMID_PCT) {
+                used &= ~(1 << s);
+            }
+        }
+    } else if (n == 2 && (fabsf(t[0] - t[1]) > FUSION_OUTLIER_TEMP_C || fabsf(h[0] - h[1]) > FUSION_OUTLIER_HUMID_PCT)) {
+        // No majority — keep the source with the smaller temperature noise
+        int8_t best = -1;
+        for (uint8_t s = 0; s < CLIMATE_SOURCE_COUNT; s++) {
+            if ((present & (1 << s)) && (best < 0 || models[s].tempSigma < models[best].tempSigma)) best = s;
+        }
+        used = (1 << best);
+    }
+    if (used == 0) used = present; // all disagree — fall back to averaging everything
+
+    float tSum = 0.0f, tWeight = 0.0f, hSum = 0.0f, hWeight = 0.0f;
+    for (uint8_t s = 0; s < CLIMATE_SOURCE_COUNT; s++) {
+        if (!(used & (1 << s))) continue;
+        const float wt = 1.0f / (models[s].tempSigma * models[s].tempSigma);
+        const float wh = 1.0f / (models[s].humidSigma * models[s].humidSigma);
+        tSum += wt * temps[s];
+        tWeight += wt;
+        hSum += wh * humids[s];
+        hWeight += wh;
+    }
+    out.temperature = tSum / tWeight;
+    out.humidity    = hSum / hWeight;
+    out.used        = used;
+    out.rejected    = present & ~used;
+    out.success     = true;
+    return out;
+}
+
+const char* fusionSourceName(ClimateSource source) {
+    return source < CLIMATE_SOURCE_COUNT ? models[source].name : "?";
+}
@@ -0,0 +1,36 @@
+#ifndef FUSION_H
+#define FUSION_H
+
+#include "globals.h"
+
+// ── Temperature / humidity fusion ─────────────────────────────────────────
+// Each cycle, every source that read successfully is passed to fusionAdd().
+// fusionResult() then:
+//   1. removes each source's self-heating offset, re-expressing its humidity
+//      at the corrected temperature;
+//   2. drops sources that disagree with the rest (with two sources, the
+//      noisier one);
+//   3. returns the inverse-variance weighted mean.
+// Noise figures and offsets are the FUSION_* constants in config.h.
+
+enum ClimateSource : uint8_t {
+    CLIMATE_DHT,
+    CLIMATE_SHT40,
+    CLIMATE_SCD41,
+    CLIMATE_SOURCE_COUNT
+};
+
+struct FusedClimate {
+    float   temperature;
+    float   humidity;
+    uint8_t used;     // bit per ClimateSource included
+    uint8_t rejected; // bit per ClimateSource dropped as an outlier
+    bool    success;
+};
+
+void         fusionReset();
+void         fusionAdd(ClimateSource source, float temperature, float humidity);
+FusedClimate fusionResult();
+const char*  fusionSourceName(ClimateSource source);
+
+#endif // FUSION_H
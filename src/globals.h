@@ -20,10 +20,14 @@ struct Pms5003Data { float pm1; float pm25; float pm10;
                      float pm1Std; float pm25Std; float pm10Std; // Standard particle (CF=1, PM_SP_UG) values
                      bool success; };
 struct Scd41Data   { float co2; float temperature; float humidity; bool success; };
+struct JsyChannel  {
+    float  voltage; float current; float power; float powerFactor; // power in W, negative when exporting
+    double energy;    // double for cumulative kWh precision
+    bool   exporting; // power flowing back to the grid
+};
 struct Jsy194gData {
-    float  voltage; float current; float power;
-    float  powerFactor; float frequency;
-    double energy; // double for cumulative kWh precision
+    JsyChannel ch[JSY_CHANNELS]; // ch[0] = channel 1
+    float  frequency;
     bool   success;
 };
 
@@ -37,23 +41,52 @@ extern RTC_DATA_ATTR uint8_t rtcWifiChannel; // ESP-NOW: cached WiFi channel; 0
 extern BoardConfig boardConfig;
 extern char macAddress[18];
 
+// Board profile tests — use these rather than the BoardConfig fields. With a
+// compile-time profile (BUILD_PROFILE in config.h) they fold to constants and
+// the code they guard is dropped from the image.
+inline bool hasSensor(uint32_t flags) {
+    return (BUILT_SENSORS & flags) && (boardConfig.sensors & flags);
+}
+inline bool isBatteryBoard() {
+    return BUILT_POWER == BUILD_POWER_ANY ? boardConfig.isBatteryPowered : BUILT_POWER == BUILD_POWER_BATTERY;
+}
+inline bool isEspNowSender() {
+    return BUILT_ESPNOW && isBatteryBoard() && boardConfig.useEspNow;
+}
+inline bool isEspNowGateway() {
+    return BUILT_ESPNOW && BUILT_POWER != BUILD_POWER_BATTERY && boardConfig.isEspNowGateway;
+}
+
 // MQTT topic buffers
 extern char temperatureTopic[TOPIC_BUF_LEN];
 extern char humidityTopic[TOPIC_BUF_LEN];
 extern char debugTopic[TOPIC_BUF_LEN];
 extern char batteryTopic[TOPIC_BUF_LEN];
-extern char co2Topic[TOPIC_BUF_LEN];
-extern char pm1Topic[TOPIC_BUF_LEN];
-extern char pm25Topic[TOPIC_BUF_LEN];
-extern char pm10Topic[TOPIC_BUF_LEN];
+extern char batterySocTopic[TOPIC_BUF_LEN];
+extern char batteryDaysTopic[TOPIC_BUF_LEN];
 extern char jsyVoltageTopic[TOPIC_BUF_LEN];
 extern char jsyCurrentTopic[TOPIC_BUF_LEN];
 extern char jsyPowerTopic[TOPIC_BUF_LEN];
 extern char jsyPfTopic[TOPIC_BUF_LEN];
 extern char jsyFreqTopic[TOPIC_BUF_LEN];
 extern char jsyEnergyTopic[TOPIC_BUF_LEN];
+extern char jsyDirectionTopic[TOPIC_BUF_LEN];
+extern char jsy2VoltageTopic[TOPIC_BUF_LEN];     // JSY channel 2
+extern char jsy2CurrentTopic[TOPIC_BUF_LEN];
+extern char jsy2PowerTopic[TOPIC_BUF_LEN];
+extern char jsy2PfTopic[TOPIC_BUF_LEN];
+extern char jsy2EnergyTopic[TOPIC_BUF_LEN];
+extern char jsy2DirectionTopic[TOPIC_BUF_LEN];
 extern char jsyDailyEnergyTopic[TOPIC_BUF_LEN];
+extern char jsyMonthlyEnergyTopic[TOPIC_BUF_LEN];
+extern char jsyLastHourEnergyTopic[TOPIC_BUF_LEN];
+extern char jsyYesterdayEnergyTopic[TOPIC_BUF_LEN];
+extern char jsyLastMonthEnergyTopic[TOPIC_BUF_LEN];
+extern char jsyIntervalEnergyTopic[TOPIC_BUF_LEN];
+extern char jsyStatsTopic[TOPIC_BUF_LEN];
 extern char acCommandTopic[TOPIC_BUF_LEN];      // IR AC command subscribe topic
+extern char metricsTopic[TOPIC_BUF_LEN];        // cycle phase timing (subtopic per phase)
+extern char sleepTopic[TOPIC_BUF_LEN];          // battery: next sleep interval
 
 // Network objects
 extern WiFiClient espClient;
@@ -72,8 +105,7 @@ extern char          debugBuf[256];
 extern char          batteryMessage[256];
 
 // Last known sensor readings (for web UI; success=false means no reading yet)
-extern Pms5003Data lastPmsData;
-extern Scd41Data   lastScd41Data;
+// (registry drivers keep theirs: driverLastReading() in drivers.h)
 extern Jsy194gData lastJsyData;
 
 #endif // GLOBALS_H
@@ -0,0 +1,208 @@
+#include "history.h"
+#include "history_flash.h"
+#include "ota.h"
+#include <time.h>
+
+struct HistoryRing {
+    int16_t* slots;    // nullptr = metric not present on this board
+    int32_t  base;     // value before the oldest slot
+    int32_t  last;     // value of the newest non-gap slot
+    bool     started;  // a value has been stored since boot
+    float    sum;      // readings in the open minute
+    uint16_t n;
+};
+
+static const char* const metricNames[HIST_METRIC_COUNT] = {"temp", "humid", "co2", "pm25", "power"};
+static const float       metricScales[HIST_METRIC_COUNT] = {100.0f, 10.0f, 1.0f, 1.0f, 1.0f};
+
+static HistoryRing rings[HIST_METRIC_COUNT];
+static uint16_t    head        = 0; // next slot to write (oldest slot once full)
+static uint16_t    count       = 0;
+static uint32_t    openMinute  = 0; // epoch minute being accumulated, 0 = clock not set yet
+static uint32_t    slotsPushed = 0; // since boot; /history readers detect reused slots
+
+static constexpr time_t HISTORY_MIN_VALID_EPOCH = 1600000000; // NTP has set the clock
+
+void initHistory() {
+    const bool present[HIST_METRIC_COUNT] = {
+        hasSensor(SENSOR_DHT | SENSOR_SHT40 | SENSOR_SCD41),
+        hasSensor(SENSOR_DHT | SENSOR_SHT40 | SENSOR_SCD41),
+        hasSensor(SENSOR_SCD41),
+        hasSensor(SENSOR_PMS5003),
+        hasSensor(SENSOR_JSY194G),
+    };
+    for (uint8_t m = 0; m < HIST_METRIC_COUNT; m++) {
+        if (!present[m] || rings[m].slots) continue;
+        rings[m].slots = (int16_t*)malloc(HISTORY_SLOTS * sizeof(int16_t));
+        if (!rings[m].slots) {
+            Serial.printf("History: no memory for %s ring\n", metricNames[m]);
+        }
+    }
+    initFlashHistory();
+}
+
+bool historyAvailable(HistoryMetric metric) {
+    return metric < HIST_METRIC_COUNT && rings[metric].slots != nullptr;
+}
+
+const char* historyMetricName(HistoryMetric metric) {
+    return metric < HIST_METRIC_COUNT ? metricNames[metric] : "?";
+}
+
+void historyRecord(HistoryMetric metric, float value) {
+    if (!historyAvailable(metric) || isnan(value)) return;
+    WebStateGuard guard;
+    rings[metric].sum += value;
+    rings[metric].n++;
+}
+
+// Append the slot for `minute` to every ring; full rings drop their oldest
+// slot into base. Minutes with any reading also go to the flash log.
+static void pushSlot(uint32_t minute) {
+    const bool full = (count == HISTORY_SLOTS);
+    float values[HIST_METRIC_COUNT];
+    bool  any = false;
+    for (uint8_t m = 0; m < HIST_METRIC_COUNT; m++) {
+        HistoryRing& r = rings[m];
+        values[m] = NAN;
+        if (!r.slots) continue;
+        if (full && r.slots[head] != HISTORY_GAP) r.base += r.slots[head];
+
+        int16_t slot = HISTORY_GAP;
+        if (r.n > 0) {
+            values[m] = r.sum / r.n;
+            any = true;
+            int32_t q = lroundf(r.sum / r.n * metricScales[m]);
+            if (!r.started) {
+                r.base = r.last = q;
+                r.started = true;
+            }
+            int32_t delta = q - r.last;
+            if (delta > INT16_MAX)  delta = INT16_MAX;
+            if (delta < -INT16_MAX) delta = -INT16_MAX; // INT16_MIN is the gap marker
+            r.last += delta;
+            slot = (int16_t)delta;
+        }
+        r.slots[head] = slot;
+        r.sum = 0.0f;
+        r.n   = 0;
+    }
+    head = (head + 1) % HISTORY_SLOTS;
+    if (!full) count++;
+    slotsPushed++;
+    if (any) flashHistoryAppend(minute * HISTORY_RESOLUTION_S, values);
+}
+
+void historyTick() {
+    time_t now = time(nullptr);
+    if (now < HISTORY_MIN_VALID_EPOCH) return;
+    uint32_t minute = now / HISTORY_RESOLUTION_S;
+    if (openMinute == 0) {
+        openMinute = minute;
+        return;
+    }
+    if (minute <= openMinute) return;
+
+    WebStateGuard guard; // rings and the flash log change under /history readers
+    // Close the open minute, then mark any minutes we missed as gaps
+    uint32_t elapsed = minute - openMinute;
+    if (elapsed > HISTORY_SLOTS) elapsed = HISTORY_SLOTS;
+    for (uint32_t i = 0; i < elapsed; i++) pushSlot(openMinute + i);
+    openMinute = minute;
+}
+
+// ── /history ──────────────────────────────────────────────────────────────
+
+// Runs on the web task. The ring is read under the web state lock one buffer
+// at a time and each buffer is sent with the lock released. Should a stalled
+// client fall so far behind that historyTick() reuses slots not yet sent, the
+// response ends early.
+static void sendHistory(HistoryMetric metric, uint32_t from, uint32_t to, bool binary) {
+    const HistoryRing& r = rings[metric];
+    uint16_t oldest, ringCount, end;
+    uint32_t firstEpoch, startPushed;
+    int32_t  value;
+    uint16_t i = 0;
+    {
+        WebStateGuard guard;
+        oldest      = (count == HISTORY_SLOTS) ? head : 0;
+        ringCount   = count;
+        firstEpoch  = (openMinute - count) * HISTORY_RESOLUTION_S;
+        startPushed = slotsPushed;
+
+        // Skip slots before `from`, carrying the running value along
+        value = r.base;
+        for (; i < count && firstEpoch + (uint32_t)i * HISTORY_RESOLUTION_S < from; i++) {
+            int16_t d = r.slots[(oldest + i) % HISTORY_SLOTS];
+            if (d != HISTORY_GAP) value += d;
+        }
+        end = i;
+        while (end < count && firstEpoch + (uint32_t)end * HISTORY_RESOLUTION_S <= to) end++;
+    }
+
+    webServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    webServer.send(200, binary ? "application/octet-stream" : "text/csv", "");
+
+    char buf[512];
+    size_t len = 0;
+    if (binary) {
+        HistoryBinHeader hdr = {{'K', 'H', 'S', '1'}, metric, 0, (uint16_t)HISTORY_RESOLUTION_S,
+                                firstEpoch + (uint32_t)i * HISTORY_RESOLUTION_S, (uint16_t)(end - i),
+                                value, metricScales[metric]};
+        memcpy(buf, &hdr, sizeof(hdr));
+        len = sizeof(hdr);
+    } else {
+        len = snprintf(buf, sizeof(buf), "epoch,%s\n", metricNames[metric]);
+    }
+    while (i < end) {
+        {
+            WebStateGuard guard;
+            // Slots reused since the start are the oldest ones, from index 0 up
+            if (ringCount + (slotsPushed - startPushed) > HISTORY_SLOTS + (uint32_t)i) break;
+            for (; i < end; i++) {
+                int16_t d = r.slots[(oldest + i) % HISTORY_SLOTS];
+                if (binary) {
+                    if (len + sizeof(int16_t) > sizeof(buf)) break;
+                    memcpy(buf + len, &d, sizeof(d));
+                    len += sizeof(d);
+                    continue;
+                }
+                if (d == HISTORY_GAP) continue;
+                if (len + 32 > sizeof(buf)) break;
+                value += d;
+                len += snprintf(buf + len, sizeof(buf) - len, "%lu,%.2f\n",
+                                (unsigned long)(firstEpoch + (uint32_t)i * HISTORY_RESOLUTION_S),
+                                value / metricScales[metric]);
+            }
+        }
+        webServer.sendContent_P(buf, len);
+        len = 0;
+    }
+    if (len > 0) webServer.sendContent_P(buf, len);
+    webServer.sendContent(""); // end of chunked response
+}
+
+void setupHistoryWeb() {
+    webServer.on("/history", HTTP_GET, []() {
+        WebRequestScope request;
+        String name = webServer.arg("metric");
+        int metric = -1;
+        for (uint8_t m = 0; m < HIST_METRIC_COUNT; m++) {
+            if (name == metricNames[m] && rings[m].slots) metric = m;
+        }
+        if (metric < 0) {
+            String avail;
+            for (uint8_t m = 0; m < HIST_METRIC_COUNT; m++) {
+                if (!rings[m].slots) continue;
+                if (avail.length()) avail += ",";
+                avail += metricNames[m];
+            }
+            webServer.send(400, "text/plain", "metric must be one of: " + avail);
+            return;
+        }
+        uint32_t from = webServer.hasArg("from") ? strtoul(webServer.arg("from").c_str(), nullptr, 10) : 0;
+        uint32_t to   = webServer.hasArg("to")   ? strtoul(webServer.arg("to").c_str(), nullptr, 10)   : UINT32_MAX;
+        sendHistory((HistoryMetric)metric, from, to, webServer.arg("format") == "bin");
+    });
+    setupFlashHistoryWeb();
+}
@@ -0,0 +1,50 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "globals.h"
+
+// ── On-device reading history (mains boards) ──────────────────────────────
+// One ring per metric of HISTORY_SLOTS one-minute slots (24 h by default),
+// allocated only for metrics the board has. Readings within a minute are
+// averaged. Each slot holds the int16 difference from the previous stored
+// value in units of 1/scale; HISTORY_GAP marks a minute with no reading.
+// The value just before the oldest slot is kept as the ring's base, so the
+// series is rebuilt by summing forward from it.
+//
+// historyTick() closes minutes as the wall clock advances and must be called
+// from the idle loop. Nothing is recorded until NTP time is valid.
+//
+// GET /history?metric=temp[&from=<epoch>&to=<epoch>][&format=csv|bin]
+//   csv: "epoch,value" lines, gaps omitted
+//   bin: HistoryBinHeader then count int16 slots, little-endian
+
+enum HistoryMetric : uint8_t {
+    HIST_TEMP,
+    HIST_HUMID,
+    HIST_CO2,
+    HIST_PM25,
+    HIST_POWER,
+    HIST_METRIC_COUNT
+};
+
+static constexpr int16_t HISTORY_GAP = INT16_MIN;
+
+struct __attribute__((packed)) HistoryBinHeader {
+    char     magic[4];    // "KHS1"
+    uint8_t  metric;
+    uint8_t  reserved;
+    uint16_t resolutionS;
+    uint32_t firstEpoch;  // time of the first slot
+    uint16_t count;       // slots that follow
+    int32_t  base;        // value before the first slot, in 1/scale units
+    float    scale;       // value = units / scale
+};
+
+void        initHistory();
+void        historyRecord(HistoryMetric metric, float value);
+void        historyTick();
+bool        historyAvailable(HistoryMetric metric);
+const char* historyMetricName(HistoryMetric metric);
+void        setupHistoryWeb();
+
+#endif // HISTORY_H
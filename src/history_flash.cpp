@@ -0,0 +1,287 @@
+#include "history_flash.h"
+#include "ota.h"
+#include <esp_partition.h>
+
+static constexpr size_t   BLOCK_SIZE        = SPI_FLASH_SEC_SIZE;
+static constexpr size_t   HEADER_SIZE       = sizeof(FlashBlockHeader);
+static constexpr size_t   HEADER_FIXED_SIZE = offsetof(FlashBlockHeader, commits);
+static constexpr size_t   DATA_SIZE         = BLOCK_SIZE - HEADER_SIZE;
+static constexpr size_t   MAX_RECORD_BYTES  = (4 + 32 + HIST_METRIC_COUNT * (2 + 5 + 5 + 32)) / 8 + 1;
+static constexpr uint16_t COMMIT_UNUSED     = 0xFFFF;
+static constexpr size_t   SEND_PIECE        = 512;   // /history/flash bytes per sendContent_P
+
+static const esp_partition_t* partition    = nullptr;
+static const uint8_t*         mapped       = nullptr; // whole partition, read-only
+static spi_flash_mmap_handle_t mapHandle;
+static uint32_t               sectorCount  = 0;
+static int32_t                newestSector = -1;      // -1 = partition empty
+static uint32_t               newestSeq    = 0;
+
+// Open block: bitstream in RAM, flushed to flash at each commit
+static bool     blockOpen      = false;
+static uint8_t  blockData[DATA_SIZE];
+static uint32_t bitPos         = 0;
+static uint16_t flushedBytes   = 0;
+static uint16_t records        = 0;
+static uint8_t  commitIndex    = 0;
+static uint8_t  recordsSinceCommit = 0;
+static uint8_t  metricMask     = 0;
+
+// Encoder state
+static uint32_t prevEpoch;
+static int32_t  prevDelta;
+static uint32_t prevBits[HIST_METRIC_COUNT];
+static uint8_t  prevLeading[HIST_METRIC_COUNT];
+static uint8_t  prevTrailing[HIST_METRIC_COUNT];
+
+static const FlashBlockHeader* headerAt(uint32_t sector) {
+    return (const FlashBlockHeader*)(mapped + sector * BLOCK_SIZE);
+}
+
+static bool headerValid(const FlashBlockHeader* h) {
+    return h->magic == FLASH_HISTORY_MAGIC && h->version == FLASH_HISTORY_VERSION;
+}
+
+static uint16_t committedBytes(const FlashBlockHeader* h) {
+    uint16_t bytes = 0;
+    for (uint8_t c = 0; c < FLASH_HISTORY_COMMITS && h->commits[c].bytes != COMMIT_UNUSED; c++) {
+        bytes = h->commits[c].bytes;
+    }
+    return bytes;
+}
+
+void initFlashHistory() {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)0x40, "history");
+    if (!partition) {
+        Serial.println("History: no 'history' partition — flash log disabled (see partitions.csv)");
+        return;
+    }
+    if (esp_partition_mmap(partition, 0, partition->size, SPI_FLASH_MMAP_DATA,
+                           (const void**)&mapped, &mapHandle) != ESP_OK) {
+        Serial.println("History: mmap of history partition failed — flash log disabled");
+        partition = nullptr;
+        return;
+    }
+    sectorCount = partition->size / BLOCK_SIZE;
+
+    for (uint32_t s = 0; s < sectorCount; s++) {
+        const FlashBlockHeader* h = headerAt(s);
+        if (!headerValid(h)) continue;
+        if (newestSector < 0 || (int32_t)(h->seq - newestSeq) > 0) {
+            newestSector = s;
+            newestSeq    = h->seq;
+        }
+    }
+    for (uint8_t m = 0; m < HIST_METRIC_COUNT; m++) {
+        if (historyAvailable((HistoryMetric)m)) metricMask |= (1 << m);
+    }
+    Serial.printf("History: flash log %u sectors, newest seq %lu\n", sectorCount, (unsigned long)newestSeq);
+}
+
+// ── Bitstream ─────────────────────────────────────────────────────────────
+
+static void putBits(uint32_t value, uint8_t n) {
+    while (n > 0) {
+        n--;
+        if ((value >> n) & 1) blockData[bitPos >> 3] |= 0x80 >> (bitPos & 7);
+        bitPos++;
+    }
+}
+
+static void putTimestamp(uint32_t epoch) {
+    if (records == 0) {
+        putBits(epoch, 32);
+        prevDelta = HISTORY_RESOLUTION_S;
+    } else {
+        int32_t delta = (int32_t)(epoch - prevEpoch);
+        int32_t dod   = delta - prevDelta;
+        if (dod == 0) {
+            putBits(0, 1);
+        } else if (dod >= -63 && dod <= 64) {
+            putBits(0x2, 2);
+            putBits(dod + 63, 7);
+        } else if (dod >= -255 && dod <= 256) {
+            putBits(0x6, 3);
+            putBits(dod + 255, 9);
+        } else if (dod >= -2047 && dod <= 2048) {
+            putBits(0xE, 4);
+            putBits(dod + 2047, 12);
+        } else {
+            putBits(0xF, 4);
+            putBits((uint32_t)dod, 32);
+        }
+        prevDelta = delta;
+    }
+    prevEpoch = epoch;
+}
+
+static void putValue(uint8_t m, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    if (records == 0) {
+        putBits(bits, 32);
+        prevBits[m]     = bits;
+        prevLeading[m]  = 0xFF; // no window yet
+        prevTrailing[m] = 0;
+        return;
+    }
+    uint32_t x = bits ^ prevBits[m];
+    prevBits[m] = bits;
+    if (x == 0) {
+        putBits(0, 1);
+        return;
+    }
+    uint8_t leading  = __builtin_clz(x);
+    uint8_t trailing = __builtin_ctz(x);
+    if (leading > 31) leading = 31;
+    putBits(1, 1);
+    if (prevLeading[m] != 0xFF && leading >= prevLeading[m] && trailing >= prevTrailing[m]) {
+        // Meaningful bits fit in the previous window
+        putBits(0, 1);
+        putBits(x >> prevTrailing[m], 32 - prevLeading[m] - prevTrailing[m]);
+    } else {
+        uint8_t sig = 32 - leading - trailing;
+        putBits(1, 1);
+        putBits(leading, 5);
+        putBits(sig - 1, 5);
+        putBits(x >> trailing, sig);
+        prevLeading[m]  = leading;
+        prevTrailing[m] = trailing;
+    }
+}
+
+// ── Blocks ────────────────────────────────────────────────────────────────
+
+// Append the new bitstream bytes and record them in the next commit slot.
+// The stream is padded to a byte boundary; the decoder skips to the
+// committed byte count after each slot's records.
+static void commitBlock() {
+    if (!blockOpen || records == 0) return;
+    bitPos = (bitPos + 7) & ~7u;
+    const uint16_t bytes = bitPos >> 3;
+    const size_t   base  = (size_t)newestSector * BLOCK_SIZE;
+    if (bytes > flushedBytes) {
+        esp_partition_write(partition, base + HEADER_SIZE + flushedBytes, blockData + flushedBytes, bytes - flushedBytes);
+        flushedBytes = bytes;
+    }
+    FlashCommit commit = {bytes, records};
+    esp_partition_write(partition, base + HEADER_FIXED_SIZE + commitIndex * sizeof(FlashCommit), &commit, sizeof(commit));
+    commitIndex++;
+    recordsSinceCommit = 0;
+    if (commitIndex >= FLASH_HISTORY_COMMITS) blockOpen = false;
+}
+
+static bool openBlock(uint32_t epoch) {
+    for (uint32_t attempt = 0; attempt < sectorCount; attempt++) {
+        uint32_t sector = (newestSector + 1 + attempt) % sectorCount;
+        const FlashBlockHeader* old = headerAt(sector);
+        uint32_t eraseCount = headerValid(old) ? old->eraseCount + 1 : 1;
+        if (esp_partition_erase_range(partition, sector * BLOCK_SIZE, BLOCK_SIZE) != ESP_OK) {
+            Serial.printf("History: erase of sector %lu failed, skipping\n", (unsigned long)sector);
+            continue;
+        }
+        FlashBlockHeader h;
+        memset(&h, 0xFF, sizeof(h));
+        h.magic       = FLASH_HISTORY_MAGIC;
+        h.seq         = newestSeq + 1;
+        h.eraseCount  = eraseCount;
+        h.startEpoch  = epoch;
+        h.resolutionS = HISTORY_RESOLUTION_S;
+        h.metricMask  = metricMask;
+        h.version     = FLASH_HISTORY_VERSION;
+        if (esp_partition_write(partition, sector * BLOCK_SIZE, &h, HEADER_FIXED_SIZE) != ESP_OK) continue;
+
+        newestSector = sector;
+        newestSeq    = h.seq;
+        memset(blockData, 0, sizeof(blockData));
+        bitPos = flushedBytes = records = commitIndex = recordsSinceCommit = 0;
+        blockOpen = true;
+        return true;
+    }
+    return false;
+}
+
+void flashHistoryAppend(uint32_t epoch, const float values[HIST_METRIC_COUNT]) {
+    if (!partition || metricMask == 0) return;
+    if (blockOpen && (bitPos >> 3) + MAX_RECORD_BYTES > DATA_SIZE) {
+        commitBlock();
+        blockOpen = false;
+    }
+    if (!blockOpen && !openBlock(epoch)) return;
+
+    putTimestamp(epoch);
+    for (uint8_t m = 0; m < HIST_METRIC_COUNT; m++) {
+        if (metricMask & (1 << m)) putValue(m, values[m]);
+    }
+    records++;
+    if (++recordsSinceCommit >= FLASH_HISTORY_FLUSH_RECORDS) commitBlock();
+}
+
+// ── /history/flash ────────────────────────────────────────────────────────
+
+// Send one block with no lock held. The header is snapshotted so the commit
+// slots a client decodes match the bytes sent — an append may fill another
+// slot meanwhile, adding bytes after them. The bitstream goes out straight
+// from the mapped partition in SEND_PIECE pieces. Returns false if the
+// sector was recycled for a new block while a piece went out (a client
+// stalled for hours): that piece may be from the new block, so the response
+// ends there.
+static bool sendBlock(uint32_t sector) {
+    const FlashBlockHeader* h = headerAt(sector);
+    FlashBlockHeader header;
+    memcpy(&header, h, HEADER_SIZE);
+    webServer.sendContent_P((const char*)&header, HEADER_SIZE);
+
+    const char* data  = (const char*)h + HEADER_SIZE;
+    size_t      total = committedBytes(&header);
+    for (size_t sent = 0; sent < total;) {
+        size_t n = total - sent < SEND_PIECE ? total - sent : SEND_PIECE;
+        webServer.sendContent_P(data + sent, n);
+        sent += n;
+        if (h->seq != header.seq) return false;
+    }
+    return h->seq == header.seq;
+}
+
+void setupFlashHistoryWeb() {
+    webServer.on("/history/flash", HTTP_GET, []() {
+        WebRequestScope request;
+        int32_t newest;
+        {
+            WebStateGuard guard;
+            newest = newestSector;
+        }
+        if (!partition || newest < 0) {
+            webServer.send(404, "text/plain", "No flash history");
+            return;
+        }
+        uint32_t from = webServer.hasArg("from") ? strtoul(webServer.arg("from").c_str(), nullptr, 10) : 0;
+        uint32_t to   = webServer.hasArg("to")   ? strtoul(webServer.arg("to").c_str(), nullptr, 10)   : UINT32_MAX;
+
+        webServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        webServer.send(200, "application/octet-stream", "");
+
+        // Walk sectors oldest first. A block is sent once the next block's
+        // start shows that it reaches `from`; the newest block always is.
+        int32_t  pending      = -1;
+        uint32_t pendingStart = 0;
+        bool     ok           = true;
+        for (uint32_t i = 1; ok && i <= sectorCount; i++) {
+            uint32_t sector = (newest + i) % sectorCount;
+            bool     usable;
+            uint32_t start;
+            {
+                WebStateGuard guard;
+                const FlashBlockHeader* h = headerAt(sector);
+                usable = headerValid(h) && committedBytes(h) > 0;
+                start  = h->startEpoch;
+            }
+            if (!usable) continue;
+            if (pending >= 0 && start > from && pendingStart <= to) ok = sendBlock(pending);
+            pending      = sector;
+            pendingStart = start;
+        }
+        if (ok && pending >= 0 && pendingStart <= to) sendBlock(pending);
+        webServer.sendContent("");
+    });
+}
@@ -0,0 +1,47 @@
+#ifndef HISTORY_FLASH_H
+#define HISTORY_FLASH_H
+
+#include "history.h"
+
+// ── Long-term history in the "history" flash partition ────────────────────
+// Each 4 KB sector holds one block. A block has a FlashBlockHeader followed
+// by a bitstream with one record per minute closed by history.cpp. Timestamps
+// are delta-of-delta encoded and values are XORed with the previous value of
+// the same metric (Gorilla-style), so a steady reading costs about one bit.
+//
+// Blocks are written in order around the partition, so every sector is
+// erased once per lap. A sector that fails to erase is skipped. The bitstream
+// is built in RAM and appended to flash every FLASH_HISTORY_FLUSH_RECORDS
+// records. Each append fills the next commit slot in the header; slots start
+// erased, so no rewrite is needed. A reboot loses at most the records since
+// the last commit and starts a new block.
+//
+// GET /history/flash[?from=<epoch>&to=<epoch>] returns the blocks covering
+// the range, oldest first. Each is sent straight from the memory-mapped
+// partition as the header plus its committed bytes.
+
+static constexpr uint32_t FLASH_HISTORY_MAGIC   = 0x4B485331; // "KHS1"
+static constexpr uint8_t  FLASH_HISTORY_VERSION = 1;
+static constexpr uint8_t  FLASH_HISTORY_COMMITS = 60;
+
+struct FlashCommit {
+    uint16_t bytes;   // bitstream bytes valid after this commit (0xFFFF = unused)
+    uint16_t records; // records decodable from them
+};
+
+struct FlashBlockHeader {
+    uint32_t    magic;
+    uint32_t    seq;         // +1 per block; the newest block has the highest
+    uint32_t    eraseCount;  // times this sector has been erased
+    uint32_t    startEpoch;  // time of the first record
+    uint16_t    resolutionS;
+    uint8_t     metricMask;  // bit m set = HistoryMetric m present in every record
+    uint8_t     version;
+    FlashCommit commits[FLASH_HISTORY_COMMITS];
+};
+
+void initFlashHistory();
+void flashHistoryAppend(uint32_t epoch, const float values[HIST_METRIC_COUNT]);
+void setupFlashHistoryWeb();
+
+#endif // HISTORY_FLASH_H
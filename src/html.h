@@ -1,208 +1,23 @@
+#include "web_assets.h"
+
+// Status page shell, streamed by the / handler around the server-rendered
+// rows. Styles and script are static gzip assets (web/, scripts/web_assets.py)
+// cached by the browser under a content-hash URL.
 
 const char* info_html = R"=====(
 <!DOCTYPE html>
 <html>
 <head>
   <title>Klaussometer Sensor Info</title>
-  <style>
-    body {
-      background-color: #f0f2f5;
-      font-family: Arial, sans-serif;
-      display: flex;
-      justify-content: center;
-      align-items: center;
-      height: 100vh;
-      margin: 0;
-      color: #333;
-    }
-    .container {
-      background-color: #fff;
-      padding: 30px;
-      border-radius: 10px;
-      box-shadow: 0 4px 8px rgba(0, 0, 0, 0.1);
-      /* text-align: center; <-- REMOVED to enable left alignment of content */
-      width: 90%;
-      max-width: 400px;
-    }
-    h1 {
-      color: #007bff;
-      margin-bottom: 20px;
-      text-align: center; /* <-- Added back to center the main title */
-    }
-    p {
-        color: #555;
-        font-size: 14px;
-        text-align: left;
-        margin: 5px 0;
-    }
-    .section-title {
-        font-weight: bold;
-        color: #007bff;
-        margin-top: 20px;
-        text-align: left; /* <-- Explicitly left-align section titles */
-    }
-    .link-button {
-        display: inline-block;
-        background-color: #007bff;
-        color: #fff;
-        border: none;
-        padding: 12px 24px;
-        border-radius: 5px;
-        cursor: pointer;
-        font-size: 16px;
-        transition: background-color 0.3s ease;
-        text-decoration: none;
-        margin-top: 20px;
-    }
-    .link-button:hover {
-      background-color: #0056b3;
-    }
-    .data-table {
-      width: 100%;
-      border-collapse: collapse;
-      margin-bottom: 10px;
-    }
-    .data-table td {
-      padding: 4px 0;
-      text-align: left;
-      font-size: 14px;
-      color: #555;
-    }
-    .data-table tr td:first-child {
-      width: 50%; /* Sets the fixed width for the label column across both tables */
-      white-space: nowrap;
-      padding-right: 10px; /* <-- ADDED SPACE BEFORE THE VALUE */
-    }  
-  </style>
+  <link rel="stylesheet" href="/status.css?v=)=====" WEB_ASSETS_HASH R"=====(">
 </head>
 <body>
   <div class="container">
     <h1>Klaussometer Sensor Info</h1>
     {{content}}
     <a href="/update" class="link-button">Update Firmware</a>
-    <script>
-        function tryUpdate(id, value) {
-            var el = document.getElementById(id);
-            if (el) el.innerHTML = value;
-        }
-
-        function updateData() {
-            var xhttp = new XMLHttpRequest();
-            xhttp.onreadystatechange = function() {
-                if (this.readyState == 4 && this.status == 200) {
-                    var data = JSON.parse(this.responseText);
-                    tryUpdate('time',      data.time);
-                    tryUpdate('uptime',    data.uptime);
-                    tryUpdate('temp',      data.temperature);
-                    tryUpdate('humid',     data.humidity);
-                    tryUpdate('voltage',   data.voltage);
-                    tryUpdate('co2',       data.co2);
-                    tryUpdate('pm1',       data.pm1);
-                    tryUpdate('pm25',      data.pm25);
-                    tryUpdate('pm10',      data.pm10);
-                    tryUpdate('acVoltage', data.acVoltage);
-                    tryUpdate('acCurrent', data.acCurrent);
-                    tryUpdate('acPower',   data.acPower);
-                    tryUpdate('acPf',      data.acPf);
-                    tryUpdate('acFreq',    data.acFreq);
-                    tryUpdate('acEnergy',  data.acEnergy);
-                }
-            };
-            xhttp.open("GET", "/data", true);
-            xhttp.send();
-        }
-
-        window.onload = function() { updateData(); };
-        setInterval(updateData, 5000);
-    </script>
+    <script src="/status.js?v=)=====" WEB_ASSETS_HASH R"=====("></script>
   </div>
 </body>
 </html>
 )=====";
-
-const char* ota_html = R"=====(
-<!DOCTYPE html>
-<html>
-<head>
-  <title>Klaussometer Sensor OTA Update</title>
-  <style>
-    body {
-      background-color: #f0f2f5;
-      font-family: Arial, sans-serif;
-      display: flex;
-      justify-content: center;
-      align-items: center;
-      height: 100vh;
-      margin: 0;
-      color: #333;
-    }
-    .container {
-      background-color: #fff;
-      padding: 30px;
-      border-radius: 10px;
-      box-shadow: 0 4px 8px rgba(0, 0, 0, 0.1);
-      text-align: center;
-      width: 90%;
-      max-width: 400px;
-    }
-    h1 {
-      color: #007bff;
-      margin-bottom: 20px;
-    }
-    p {
-        color: #555;
-        font-size: 14px;
-    }
-    form {
-      margin-top: 20px;
-    }
-    input[type="file"] {
-      border: 2px dashed #ccc;
-      padding: 20px;
-      border-radius: 5px;
-      width: calc(100% - 40px);
-      margin-bottom: 20px;
-    }
-    input[type="submit"] {
-      background-color: #007bff;
-      color: #fff;
-      border: none;
-      padding: 12px 24px;
-      border-radius: 5px;
-      cursor: pointer;
-      font-size: 16px;
-      transition: background-color 0.3s ease;
-    }
-    input[type="submit"]:hover {
-      background-color: #0056b3;
-    }
-    .data-table {
-      width: 100%; /* Make the table take full width of the container */
-      border-collapse: collapse; /* Remove double lines between cells */
-      margin-bottom: 10px; /* Space after the table */
-    }
-    .data-table td {
-      padding: 4px 0; /* Add some vertical spacing */
-      text-align: left; /* Ensure all content in table cells is left-aligned */
-      font-size: 14px;
-      color: #555;
-    }
-    .data-table tr td:first-child {
-      width: 50%; /* Give labels about half the table width */
-      white-space: nowrap; /* Prevent labels from wrapping */
-      padding-right: 10px; /* Add space between label and value */
-    }
-  </style>
-</head>
-<body>
-  <div class="container">
-    <h1>Klaussometer Sensor OTA Update</h1>
-    <p>Current Firmware Version: {{FIRMWARE_VERSION}}</p>
-    <form method="POST" action="/update" enctype="multipart/form-data">
-      <input type="file" name="firmware" id="firmware" accept=".bin">
-      <input type="submit" value="Update Firmware">
-    </form>
-  </div>
-</body>
-</html>
-)=====";
\ No newline at end of file
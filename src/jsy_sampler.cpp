@@ -0,0 +1,60 @@
+#include "jsy_sampler.h"
+#include "metrics.h"
+#include "ota.h"
+#include "sensors.h"
+
+static JsyInterval   interval        = {};
+static unsigned long intervalStartMs = 0;
+static unsigned long lastSampleMs    = 0;
+static unsigned long prevSampleMs    = 0;     // time of the previous successful sample
+static float         prevPower       = NAN;   // its power, for the trapezoid
+
+static void runningAdd(RunningStat& s, float x) {
+    if (s.n == 0 || x < s.min) s.min = x;
+    if (s.n == 0 || x > s.max) s.max = x;
+    s.n++;
+    double delta = x - s.mean;
+    s.mean += delta / s.n;
+    s.m2   += delta * (x - s.mean);
+}
+
+float runningStdDev(const RunningStat& s) {
+    return (s.n > 1) ? (float)sqrt(s.m2 / (s.n - 1)) : 0.0f;
+}
+
+bool jsySampleNow() {
+    unsigned long t0 = millis();
+    Jsy194gData jsy = readJsy194g();
+    lastSampleMs = millis();
+    metricsRecord(PHASE_JSY_READ, lastSampleMs - t0);
+    if (!jsy.success) return false;
+
+    if (intervalStartMs == 0) intervalStartMs = t0;
+    const JsyChannel& ch1 = jsy.ch[0];
+    runningAdd(interval.voltage, ch1.voltage);
+    runningAdd(interval.current, ch1.current);
+    runningAdd(interval.power,   ch1.power);
+    if (!isnan(prevPower)) {
+        double dtHours = (t0 - prevSampleMs) / 3600000.0;
+        interval.energyWh += (prevPower + ch1.power) * 0.5 * dtHours;
+    }
+    prevPower    = ch1.power;
+    prevSampleMs = t0;
+    interval.last = jsy;
+    WebStateGuard guard;
+    lastJsyData   = jsy; // status page and /metrics show the live value
+    return true;
+}
+
+void jsySamplerTick() {
+    if (!hasSensor(SENSOR_JSY194G)) return;
+    if (lastSampleMs != 0 && millis() - lastSampleMs < JSY_SAMPLE_INTERVAL_MS) return;
+    jsySampleNow();
+}
+
+void jsyTakeInterval(JsyInterval& out) {
+    out = interval;
+    out.durationMs = intervalStartMs ? millis() - intervalStartMs : 0;
+    interval = {};
+    intervalStartMs = millis();
+}
@@ -0,0 +1,38 @@
+#ifndef JSY_SAMPLER_H
+#define JSY_SAMPLER_H
+
+#include "globals.h"
+
+// ── JSY-MK-194G background sampler (mains boards) ────────────────────────
+// jsySamplerTick() polls the meter every JSY_SAMPLE_INTERVAL_MS and folds
+// each sample into per-interval statistics; call it from the idle loop.
+// jsyTakeInterval() returns the statistics gathered since the previous call
+// (one publish interval) and starts a new interval. Statistics cover
+// channel 1; channel 2 is reported from the last sample.
+//
+// energyWh is the trapezoidal integral of active power between samples. It
+// resolves fractions of a Wh between updates of the meter's energy register.
+
+struct RunningStat {
+    uint32_t n;
+    float    min;
+    float    max;
+    double   mean; // Welford running mean / sum of squared deviations
+    double   m2;
+};
+
+struct JsyInterval {
+    RunningStat voltage;
+    RunningStat current;
+    RunningStat power;
+    double      energyWh;  // integrated over the interval
+    uint32_t    durationMs;
+    Jsy194gData last;      // most recent successful sample (success=false if none)
+};
+
+void  jsySamplerTick();
+bool  jsySampleNow();     // take a sample immediately; false on read failure
+void  jsyTakeInterval(JsyInterval& out);
+float runningStdDev(const RunningStat& s);
+
+#endif // JSY_SAMPLER_H
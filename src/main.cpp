@@ -1,9 +1,20 @@
 #include "globals.h"
+#include "battery.h"
+#include "drivers.h"
+#include "energy.h"
 #include "espnow.h"
+#include "fusion.h"
+#include "history.h"
 #include "ir_ac.h"
+#include "jsy_sampler.h"
+#include "metrics.h"
+#include "modbus.h"
 #include "network.h"
 #include "ota.h"
+#include "power.h"
 #include "sensors.h"
+#include "sleep_adapt.h"
+#include "web_events.h"
 #include <WiFi.h>
 
 // Global definitions (extern-declared in globals.h)
@@ -20,18 +31,31 @@ char temperatureTopic[TOPIC_BUF_LEN];
 char humidityTopic[TOPIC_BUF_LEN];
 char debugTopic[TOPIC_BUF_LEN];
 char batteryTopic[TOPIC_BUF_LEN];
-char co2Topic[TOPIC_BUF_LEN];
-char pm1Topic[TOPIC_BUF_LEN];
-char pm25Topic[TOPIC_BUF_LEN];
-char pm10Topic[TOPIC_BUF_LEN];
+char batterySocTopic[TOPIC_BUF_LEN];
+char batteryDaysTopic[TOPIC_BUF_LEN];
 char jsyVoltageTopic[TOPIC_BUF_LEN];
 char jsyCurrentTopic[TOPIC_BUF_LEN];
 char jsyPowerTopic[TOPIC_BUF_LEN];
 char jsyPfTopic[TOPIC_BUF_LEN];
 char jsyFreqTopic[TOPIC_BUF_LEN];
 char jsyEnergyTopic[TOPIC_BUF_LEN];
+char jsyDirectionTopic[TOPIC_BUF_LEN];
+char jsy2VoltageTopic[TOPIC_BUF_LEN];
+char jsy2CurrentTopic[TOPIC_BUF_LEN];
+char jsy2PowerTopic[TOPIC_BUF_LEN];
+char jsy2PfTopic[TOPIC_BUF_LEN];
+char jsy2EnergyTopic[TOPIC_BUF_LEN];
+char jsy2DirectionTopic[TOPIC_BUF_LEN];
 char jsyDailyEnergyTopic[TOPIC_BUF_LEN];
+char jsyMonthlyEnergyTopic[TOPIC_BUF_LEN];
+char jsyLastHourEnergyTopic[TOPIC_BUF_LEN];
+char jsyYesterdayEnergyTopic[TOPIC_BUF_LEN];
+char jsyLastMonthEnergyTopic[TOPIC_BUF_LEN];
+char jsyIntervalEnergyTopic[TOPIC_BUF_LEN];
+char jsyStatsTopic[TOPIC_BUF_LEN];
 char acCommandTopic[TOPIC_BUF_LEN];
+char metricsTopic[TOPIC_BUF_LEN];
+char sleepTopic[TOPIC_BUF_LEN];
 
 WiFiClient espClient;
 MqttClient mqttClient(espClient);
@@ -45,16 +69,8 @@ char          lastReadingTimeStr[50] = "N/A";
 char          debugBuf[256];
 char          batteryMessage[256] = "";
 
-Pms5003Data lastPmsData   = {};
-Scd41Data   lastScd41Data = {};
 Jsy194gData lastJsyData   = {};
 
-static double        dayStartEnergy = -1.0; // -1 = not yet initialised (first boot)
-static int           lastTmYday     = -1;   // -1 = not yet initialised (first boot)
-// Sentinel: first PMS read fires after PMS5003_WARMUP_MS (not a full interval) from boot
-static unsigned long lastPmsReadMs  = 0UL - (PMS5003_READ_INTERVAL_MS - PMS5003_WARMUP_MS);
-static bool          pmsPoweredOn   = true; // true on boot (sensor starts powered)
-
 // NTP settings (used only in loop)
 static const char* const ntpServer = "pool.ntp.org";
 
@@ -67,26 +83,37 @@ void loadBoardConfig() {
     Serial.println(debugBuf); // debugMessage not yet usable (no MQTT topic set)
     boardConfig = getBoardConfig(macAddress);
 
+    // Compile-time profile: report board entries that ask for more than this
+    // image contains. The profile wins.
+    if (boardConfig.sensors & ~BUILT_SENSORS) {
+        snprintf(debugBuf, sizeof(debugBuf), "CONFIG WARNING: sensors 0x%02lx are not built into this image (profile 0x%02lx) and are ignored",
+                 (unsigned long)(boardConfig.sensors & ~BUILT_SENSORS), (unsigned long)BUILT_SENSORS);
+        Serial.println(debugBuf);
+    }
+    if (BUILT_POWER != BUILD_POWER_ANY && boardConfig.isBatteryPowered != isBatteryBoard()) {
+        Serial.println(isBatteryBoard() ? "CONFIG WARNING: board entry is mains-powered but this image is a battery build"
+                                        : "CONFIG WARNING: board entry is battery-powered but this image is a mains build");
+    }
+    if (!BUILT_ESPNOW && (boardConfig.useEspNow || boardConfig.isEspNowGateway)) {
+        Serial.println("CONFIG WARNING: board entry uses ESP-NOW but this image is built without it");
+    }
+
     // Always-present topics
     snprintf(temperatureTopic, sizeof(temperatureTopic), "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_TEMP_TOPIC);
     snprintf(humidityTopic,    sizeof(humidityTopic),    "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_HUMID_TOPIC);
     snprintf(debugTopic,       sizeof(debugTopic),       "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_DEBUG_TOPIC);
     snprintf(batteryTopic,     sizeof(batteryTopic),     "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_BATTERY_TOPIC);
+    snprintf(batterySocTopic,  sizeof(batterySocTopic),  "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_BATTERY_SOC_TOPIC);
+    snprintf(batteryDaysTopic, sizeof(batteryDaysTopic), "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_BATTERY_DAYS_TOPIC);
+    snprintf(metricsTopic,     sizeof(metricsTopic),     "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_METRICS_TOPIC);
+    snprintf(sleepTopic,       sizeof(sleepTopic),       "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_SLEEP_TOPIC);
 
-    // Sensor-specific topics
-    if (boardConfig.sensors & SENSOR_SCD41) {
-        snprintf(co2Topic, sizeof(co2Topic), "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_CO2_TOPIC);
-    }
-    if (boardConfig.sensors & SENSOR_PMS5003) {
-        snprintf(pm1Topic,  sizeof(pm1Topic),  "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_PM1_TOPIC);
-        snprintf(pm25Topic, sizeof(pm25Topic), "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_PM25_TOPIC);
-        snprintf(pm10Topic, sizeof(pm10Topic), "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_PM10_TOPIC);
-    }
-    if (boardConfig.sensors & SENSOR_IR_AC) {
+    // Sensor-specific topics (registry drivers build their own in initDrivers())
+    if (hasSensor(SENSOR_IR_AC)) {
         snprintf(acCommandTopic, sizeof(acCommandTopic), "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_IR_AC_TOPIC);
     }
 
-    if (boardConfig.sensors & SENSOR_JSY194G) {
+    if (hasSensor(SENSOR_JSY194G)) {
         snprintf(jsyVoltageTopic, sizeof(jsyVoltageTopic), "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_JSY_VOLTAGE_TOPIC);
         snprintf(jsyCurrentTopic, sizeof(jsyCurrentTopic), "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_JSY_CURRENT_TOPIC);
         snprintf(jsyPowerTopic,   sizeof(jsyPowerTopic),   "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_JSY_POWER_TOPIC);
@@ -94,19 +121,41 @@ void loadBoardConfig() {
         snprintf(jsyFreqTopic,    sizeof(jsyFreqTopic),    "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_JSY_FREQ_TOPIC);
         snprintf(jsyEnergyTopic,       sizeof(jsyEnergyTopic),       "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_JSY_ENERGY_TOPIC);
         snprintf(jsyDailyEnergyTopic,  sizeof(jsyDailyEnergyTopic),  "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_JSY_DAILY_ENERGY_TOPIC);
+        snprintf(jsyMonthlyEnergyTopic,   sizeof(jsyMonthlyEnergyTopic),   "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_JSY_MONTHLY_ENERGY_TOPIC);
+        snprintf(jsyLastHourEnergyTopic,  sizeof(jsyLastHourEnergyTopic),  "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_JSY_LAST_HOUR_ENERGY_TOPIC);
+        snprintf(jsyYesterdayEnergyTopic, sizeof(jsyYesterdayEnergyTopic), "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_JSY_YESTERDAY_ENERGY_TOPIC);
+        snprintf(jsyLastMonthEnergyTopic, sizeof(jsyLastMonthEnergyTopic), "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_JSY_LAST_MONTH_ENERGY_TOPIC);
+        snprintf(jsyDirectionTopic,    sizeof(jsyDirectionTopic),    "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_JSY_DIRECTION_TOPIC);
+        snprintf(jsy2VoltageTopic,     sizeof(jsy2VoltageTopic),     "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_JSY2_VOLTAGE_TOPIC);
+        snprintf(jsy2CurrentTopic,     sizeof(jsy2CurrentTopic),     "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_JSY2_CURRENT_TOPIC);
+        snprintf(jsy2PowerTopic,       sizeof(jsy2PowerTopic),       "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_JSY2_POWER_TOPIC);
+        snprintf(jsy2PfTopic,          sizeof(jsy2PfTopic),          "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_JSY2_PF_TOPIC);
+        snprintf(jsy2EnergyTopic,      sizeof(jsy2EnergyTopic),      "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_JSY2_ENERGY_TOPIC);
+        snprintf(jsy2DirectionTopic,   sizeof(jsy2DirectionTopic),   "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_JSY2_DIRECTION_TOPIC);
+        snprintf(jsyIntervalEnergyTopic, sizeof(jsyIntervalEnergyTopic), "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_JSY_INTERVAL_ENERGY_TOPIC);
+        snprintf(jsyStatsTopic,        sizeof(jsyStatsTopic),        "%s%s%s", MQTT_TOPIC_USER, boardConfig.roomName, MQTT_JSY_STATS_TOPIC);
     }
+}
 
-    // Create DHT object now that the correct pin is known
-    if (boardConfig.sensors & SENSOR_DHT) {
-        dht = new DHT(boardConfig.dhtDataPin, boardConfig.dhtType);
-    }
+// True if this wake will use WiFi: always on the WiFi/MQTT path; on the
+// ESP-NOW path only when the channel is unknown or an OTA check is due
+// (mirrors the decision in loop()).
+static bool wifiNeededThisWake() {
+    if (!isEspNowSender()) return true;
+    return rtcWifiChannel == 0 || secondsSinceOta + sleepAdaptLastSeconds() >= ESPNOW_OTA_INTERVAL_S;
 }
 
 void deepSleep(int sleepSeconds) {
+    wakeProfileEnter(WAKE_SLEEP);
     esp_sleep_enable_timer_wakeup((uint64_t)sleepSeconds * MICROSECONDS_IN_SECOND);
-    snprintf(debugBuf, sizeof(debugBuf), "Entering deep sleep for %d seconds...", sleepSeconds);
+    sleepAdaptSlept((uint16_t)sleepSeconds);
+    unsigned long awakeMs = millis();
+    metricsRecord(PHASE_CYCLE, awakeMs);
+    snprintf(debugBuf, sizeof(debugBuf), "Entering deep sleep for %d seconds (awake %lu ms)...",
+             sleepSeconds, awakeMs);
     debugMessage(debugBuf, false);
     WiFi.disconnect();
+    wakeProfileFinish((uint32_t)sleepSeconds);
     esp_deep_sleep_start();
 }
 
@@ -118,61 +167,58 @@ void setup() {
     loadBoardConfig();
 
     // Validate configuration — warn about combinations that cannot work correctly
-    if (boardConfig.isBatteryPowered && (boardConfig.sensors & SENSOR_PMS5003)) {
+    if (isBatteryBoard() && hasSensor(SENSOR_PMS5003)) {
         Serial.println("CONFIG WARNING: PMS5003 is not supported on battery-powered boards. "
                        "The sensor requires a 30-second warm-up that is incompatible with deep sleep. "
                        "Remove SENSOR_PMS5003 from this board's config.");
     }
-    if (boardConfig.isBatteryPowered && (boardConfig.sensors & SENSOR_JSY194G)) {
+    if (isBatteryBoard() && hasSensor(SENSOR_JSY194G)) {
         Serial.println("CONFIG WARNING: JSY-MK-194G is not supported on battery-powered boards. "
                        "Modbus RTU over UART is incompatible with deep sleep wake cycles. "
                        "Remove SENSOR_JSY194G from this board's config.");
     }
-
-    if (boardConfig.sensors & SENSOR_DHT) {
-        if (boardConfig.dhtGndPin > 0) {
-            pinMode(boardConfig.dhtGndPin, OUTPUT);
-            digitalWrite(boardConfig.dhtGndPin, LOW);    // GPIO as GND substitute
-        }
-        if (boardConfig.dhtPowerPin > 0) {
-            pinMode(boardConfig.dhtPowerPin, OUTPUT);
-            digitalWrite(boardConfig.dhtPowerPin, HIGH); // Power on early to warm up
-        }
-        dht->begin();
+    if (isBatteryBoard() && hasSensor(SENSOR_MODBUS)) {
+        Serial.println("CONFIG WARNING: Modbus devices are only polled between cycles on mains-powered boards. "
+                       "Remove SENSOR_MODBUS from this board's config.");
     }
-
-    if (boardConfig.sensors & SENSOR_PMS5003) {
-        Serial2.begin(9600, SERIAL_8N1, boardConfig.pmsRxPin, boardConfig.pmsTxPin);
-        if (boardConfig.pmsPowerPin >= 0) {
-            pinMode(boardConfig.pmsPowerPin, OUTPUT);
-            digitalWrite(boardConfig.pmsPowerPin, HIGH);
-        }
+    if (isBatteryBoard() && hasSensor(SENSOR_SCD41) &&
+            boardConfig.scd41Mode != SCD41_MODE_SINGLE_SHOT) {
+        Serial.println("CONFIG WARNING: SCD41 in periodic mode keeps measuring through deep sleep. "
+                       "Set scd41Mode = SCD41_MODE_SINGLE_SHOT on battery-powered boards.");
     }
 
-    if (boardConfig.sensors & SENSOR_SCD41) {
-        initScd41(boardConfig.i2cSdaPin, boardConfig.i2cSclPin);
+    // Boot pipeline: start the slow, independent steps first — WiFi/DHCP
+    // association, then every driver's init and measurement start (DHT
+    // power-on guard, SCD41 single-shot) — so they run while the rest of the
+    // wake work proceeds. loop() joins WiFi via setupWifi() only when data
+    // must be published.
+    if (wifiNeededThisWake()) {
+        startWifi();
     }
 
-    if (boardConfig.sensors & SENSOR_SHT40) {
-        initSht40(boardConfig.i2cSdaPin, boardConfig.i2cSclPin);
-    }
+    initDrivers();
 
-    if (boardConfig.sensors & SENSOR_JSY194G) {
-        Serial1.begin(9600, SERIAL_8N1, boardConfig.jsyRxPin, boardConfig.jsyTxPin);
+    if (hasSensor(SENSOR_JSY194G | SENSOR_MODBUS)) {
+        Serial1.begin(JSY_BAUD_RATE, SERIAL_8N1, boardConfig.jsyRxPin, boardConfig.jsyTxPin);
         if (boardConfig.jsyDePin >= 0) {
             pinMode(boardConfig.jsyDePin, OUTPUT);
             digitalWrite(boardConfig.jsyDePin, LOW); // Default: receive mode
         }
+        initModbusPoller();
     }
 
-    if (boardConfig.sensors & SENSOR_IR_AC) {
+    if (!isBatteryBoard()) {
+        initHistory();
+    }
+
+    if (hasSensor(SENSOR_IR_AC)) {
         initIrAc(boardConfig.irTxPin);
     }
 
     mqttClient.setUsernamePassword(MQTT_USER, MQTT_PASSWORD);
 
     // Set MQTT message callback once — fires whenever a subscribed message arrives
-    if (boardConfig.sensors & SENSOR_IR_AC) {
+    if (hasSensor(SENSOR_IR_AC)) {
         mqttClient.onMessage([](int /*messageSize*/) {
             static const char* const modeNames[] = { "cool", "heat", "auto", "fan", "dry" };
             static const char* const fanNames[]  = { "auto", "low",  "med",  "high", "turbo" };
@@ -218,50 +264,71 @@ void loop() {
     // ── ESP-NOW sender path (battery boards using ESP-NOW) ──────────────────
     // Reads sensors, transmits via ESP-NOW, optionally checks OTA, then sleeps.
     // This path never connects to WiFi for sensor data, saving ~95% of battery.
-    if (boardConfig.isBatteryPowered && boardConfig.useEspNow) {
+    if (isEspNowSender()) {
+        wakeProfileEnter(WAKE_SENSORS);
         EspNowPayload payload = {};
+        payload.version      = ESPNOW_PAYLOAD_VERSION;
         strncpy(payload.roomName, boardConfig.roomName, sizeof(payload.roomName) - 1);
         payload.temperature  = NAN;
         payload.humidity     = NAN;
         payload.batteryVolts = 0.0f;
         payload.bootCount    = (uint16_t)bootCount;
         payload.successCount = (uint16_t)successCount;
-
-        bool dhtOk = true;
-        if (boardConfig.sensors & SENSOR_DHT) {
-            SensorData reading = readDhtSensor();
-            if (reading.success) {
-                payload.temperature = reading.temperature;
-                payload.humidity    = reading.humidity;
-                successCount++;
-                payload.successCount = (uint16_t)successCount;
-            } else {
-                dhtOk = false;
+        payload.co2          = NAN;
+        payload.awakeMs      = wakeProfileLastAwakeMs();
+        payload.sleepS       = 0;
+        payload.wakeUah      = (uint16_t)lroundf(wakeProfileUahPerWake());
+        payload.batterySoc   = ESPNOW_BATTERY_SOC_NONE;
+        payload.batteryDays  = ESPNOW_BATTERY_DAYS_NONE;
+
+        // Same charging check as the WiFi path: a rising voltage makes the
+        // estimates meaningless, so they go out as unknown
+        if (boardConfig.battPin > 0) {
+            float prevVolts = lastVolts;  // RTC value from previous wake (0 on first boot)
+            lastVolts = payload.batteryVolts = readBatteryVoltage();
+            bool likelyCharging = (prevVolts > 0.0f) && (lastVolts - prevVolts > BATT_RISING_DELTA_V);
+            if (!likelyCharging) {
+                float soc  = batterySocPercent(payload.batteryVolts);
+                float days = batteryDaysLeft(soc);
+                if (!isnan(soc))  payload.batterySoc  = (uint8_t)lroundf(soc);
+                if (!isnan(days)) payload.batteryDays = days < ESPNOW_BATTERY_DAYS_NONE ? (uint16_t)lroundf(days) : ESPNOW_BATTERY_DAYS_NONE - 1;
             }
         }
 
-        if (boardConfig.sensors & SENSOR_SHT40) {
-            SensorData reading = readSht40();
-            if (reading.success) {
-                payload.temperature = reading.temperature;
-                payload.humidity    = reading.humidity;
-                successCount++;
-                payload.successCount = (uint16_t)successCount;
-            } else {
-                dhtOk = false; // reuse flag — causes short retry sleep on failure
-            }
+        // Measurements were started in setup(); registry order leaves SCD41
+        // last so only the remainder of its single-shot is waited.
+        bool readsOk = true;
+        fusionReset();
+        for (uint8_t i = 0; i < driverCount(); i++) {
+            DriverReading reading;
+            if (!driverRead(i, reading)) readsOk = false; // short retry sleep on failure
         }
+        payload.successCount = (uint16_t)successCount;
+        payload.co2          = driverValue("co2");
 
-        if (boardConfig.battPin > 0) {
-            payload.batteryVolts = readBatteryVoltage();
+        FusedClimate climate = fusionResult();
+        if (climate.success) {
+            payload.temperature = climate.temperature;
+            payload.humidity    = climate.humidity;
+        }
+
+        // Next sleep — sent with the packet so the gateway reports it. A failed
+        // read retries sooner; a failed send can only change it after the packet.
+        payload.sleepS      = sleepAdaptNext(payload.temperature, payload.humidity, payload.co2, payload.batteryVolts);
+        payload.sleepReason = sleepAdaptReason();
+        if (!readsOk) {
+            payload.sleepS      = ESPNOW_RETRY_SLEEP_S;
+            payload.sleepReason = SLEEP_RETRY;
         }
+        Serial.printf("Sleep: next %u s (%s)\n", payload.sleepS, sleepReasonName((SleepReason)payload.sleepReason));
 
         // Connect to WiFi when channel is unknown (first ever boot) or it is
         // time for an OTA check. Both cases read the current channel from the
         // AP association and cache it in RTC memory so subsequent boots skip WiFi.
-        secondsSinceOta += (uint32_t)boardConfig.timeToSleep;
+        secondsSinceOta += (uint32_t)sleepAdaptLastSeconds();
         bool otaDue    = (secondsSinceOta >= ESPNOW_OTA_INTERVAL_S);
         bool needsWifi = (rtcWifiChannel == 0) || otaDue;
+        wakeProfileEnter(WAKE_RADIO);
         if (needsWifi) {
             if (setupWifi()) {
                 uint8_t ch = (uint8_t)WiFi.channel();
@@ -275,11 +342,15 @@ void loop() {
                 }
             }
             WiFi.disconnect(true); // true = also disable WiFi radio
+            wakeProfileRadio(false);
         }
 
         bool espNowOk = true; // not a failure if channel not yet known (first boot)
         if (rtcWifiChannel > 0) {
+            wakeProfileEnter(WAKE_ACK);
+            unsigned long t0 = millis();
             espNowOk = espNowSend(payload, rtcWifiChannel);
+            metricsRecord(PHASE_ESPNOW_SEND, millis() - t0);
             if (!espNowOk) {
                 // All retries failed — the gateway may have moved to a different
                 // WiFi channel (router reboot, DFS, etc.). Clear the cached channel
@@ -289,6 +360,7 @@ void loop() {
                 // espNowSend() uses esp_wifi_set_channel() which corrupts the TCP stack;
                 // a full radio reset is needed before regular WiFi/MQTT will work reliably.
                 WiFi.mode(WIFI_OFF);
+                wakeProfileRadio(false);
                 delay(500);
                 if (setupWifi()) {
                     uint8_t ch = (uint8_t)WiFi.channel();
@@ -305,6 +377,13 @@ void loop() {
                             mqttSendFloat(humidityTopic, payload.humidity);
                         if (payload.batteryVolts > 0.0f)
                             mqttSendFloat(batteryTopic, payload.batteryVolts);
+                        if (payload.batterySoc != ESPNOW_BATTERY_SOC_NONE)
+                            mqttSendFloat(batterySocTopic, payload.batterySoc);
+                        if (payload.batteryDays != ESPNOW_BATTERY_DAYS_NONE)
+                            mqttSendFloat(batteryDaysTopic, payload.batteryDays);
+                        if (!isnan(payload.co2))
+                            mqttSendFloat(driverTopic("co2"), payload.co2);
+                        mqttSendFloat(sleepTopic, payload.sleepS);
                         snprintf(debugBuf, sizeof(debugBuf),
                                  "ESP-NOW fallback via WiFi | T:%.1f H:%.0f%% Bat:%.2fV Boot:%u",
                                  payload.temperature, payload.humidity, payload.batteryVolts, bootCount);
@@ -314,14 +393,15 @@ void loop() {
                     mqttClient.flush(); // ensure all messages are transmitted before closing
                     mqttClient.stop(); // close MQTT socket cleanly before radio goes down
                     WiFi.disconnect(true);
+                    wakeProfileRadio(false);
                 }
             }
         } else {
             Serial.println("ESP-NOW: channel not yet known — skipping send this boot");
         }
 
-        // Retry sooner if DHT read or ESP-NOW send failed; otherwise normal interval
-        int sleepSecs = (dhtOk && espNowOk) ? boardConfig.timeToSleep : ESPNOW_RETRY_SLEEP_S;
+        // Retry sooner if the ESP-NOW send failed; a failed read is already in sleepS
+        int sleepSecs = espNowOk ? payload.sleepS : ESPNOW_RETRY_SLEEP_S;
         deepSleep(sleepSecs);
         return; // deepSleep() does not return; this line is for clarity
     }
@@ -329,30 +409,31 @@ void loop() {
     // ── Normal path (mains boards and WiFi-connected battery boards) ─────────
     // For mains-powered devices, wait until the next reading time.
     // Skip the wait on the very first run (lastReadingTime == 0).
-    if (!boardConfig.isBatteryPowered && lastReadingTime > 0) {
+    if (!isBatteryBoard() && lastReadingTime > 0) {
         unsigned long nextReadingTime = lastReadingTime + (boardConfig.timeToSleep * 1000UL);
         while ((long)(millis() - nextReadingTime) < 0) {
-            mqttClient.poll(); // process incoming subscribed messages (e.g. IR AC commands)
-            if (boardConfig.isEspNowGateway) {
+            mqttPoll(); // process incoming subscribed messages (e.g. IR AC commands)
+            if (isEspNowGateway()) {
                 handleEspNowReceived();
                 espNowGatewayTick();
             }
-            // Power on PMS5003 early so laser stabilizes before its scheduled read
-            if ((boardConfig.sensors & SENSOR_PMS5003) && boardConfig.pmsPowerPin >= 0) {
-                unsigned long nextPmsRead = lastPmsReadMs + PMS5003_READ_INTERVAL_MS;
-                unsigned long pmsOnAt     = nextPmsRead   - PMS5003_WARMUP_MS;
-                if ((long)(millis() - pmsOnAt) >= 0 && !pmsPoweredOn) {
-                    digitalWrite(boardConfig.pmsPowerPin, HIGH);
-                    pmsPoweredOn = true;
-                }
-            }
-            webServer.handleClient();
-            delay(WEB_SERVER_POLL_INTERVAL_MS);
+            // Start measurements ahead of their reads (PMS5003 warm-up, SCD41
+            // single-shot) and latch samples as sensors report data ready
+            driversIdleTick(nextReadingTime);
+            jsySamplerTick(); // background 1 Hz power sampling between publishes
+            modbusPollTick(); // one generic Modbus device per MODBUS_POLL_INTERVAL_MS
+            historyTick();
+            idlePowerTick();
+            metricsTick();
+            idleWait(WEB_SERVER_POLL_INTERVAL_MS);
         }
     }
 
+    if (isBatteryBoard()) {
+        wakeProfileEnter(WAKE_RADIO);
+    }
     if (!setupWifi()) {
-        if (boardConfig.isBatteryPowered) {
+        if (isBatteryBoard()) {
             deepSleep(boardConfig.timeToSleep);
         } else {
             debugMessage("Failed to connect to WiFi, waiting for next cycle...", false);
@@ -373,13 +454,13 @@ void loop() {
     if (!mqttClient.connected()) {
         mqttReconnect();
         // Re-subscribe after every (re)connect — subscriptions are lost on disconnect
-        if (boardConfig.sensors & SENSOR_IR_AC) {
+        if (hasSensor(SENSOR_IR_AC)) {
             mqttClient.subscribe(acCommandTopic);
         }
     }
 
     // ESP-NOW gateway: initialise once after MQTT is up
-    if (boardConfig.isEspNowGateway) {
+    if (isEspNowGateway()) {
         static bool espNowReady = false;
         if (!espNowReady) {
             initEspNowGateway();
@@ -406,161 +487,186 @@ void loop() {
 
     // Stamp start of this cycle so the next wait interval is measured from here,
     // not from after sensor reads complete (avoids cumulative drift).
-    if (!boardConfig.isBatteryPowered) {
+    if (!isBatteryBoard()) {
         lastReadingTime = millis();
     }
 
-    // Read DHT sensor if present
-    if (boardConfig.sensors & SENSOR_DHT) {
-        SensorData reading = readDhtSensor();
-        if (!reading.success) {
-            snprintf(debugBuf, sizeof(debugBuf), "%s DHT read failed after %d retries.", timeBuffer, DHT_RETRIES);
-            debugMessage(debugBuf, true);
-            if (boardConfig.isBatteryPowered) {
-                deepSleep(boardConfig.timeToSleep);
-            }
-            // On mains boards: log and continue — other sensors (SCD41 etc.) are still read
-        } else {
-            successCount++;
-            lastTemp  = reading.temperature;
-            lastHumid = reading.humidity;
-            strncpy(lastReadingTimeStr, timeBuffer, sizeof(lastReadingTimeStr) - 1);
-            lastReadingTimeStr[sizeof(lastReadingTimeStr) - 1] = '\0';
-            // Only publish DHT temp/humidity if SCD41 is absent; SCD41 is more accurate
-            if (!(boardConfig.sensors & SENSOR_SCD41)) {
-                mqttSendFloat(temperatureTopic, reading.temperature);
-                mqttSendFloat(humidityTopic,    reading.humidity);
-            }
-        }
-    }
-
-    // Read SHT40 sensor if present
-    if (boardConfig.sensors & SENSOR_SHT40) {
-        SensorData reading = readSht40();
-        if (!reading.success) {
-            snprintf(debugBuf, sizeof(debugBuf), "%s SHT40 read failed.", timeBuffer);
-            debugMessage(debugBuf, true);
-            if (boardConfig.isBatteryPowered) {
-                deepSleep(boardConfig.timeToSleep);
-            }
-        } else {
-            successCount++;
-            lastTemp  = reading.temperature;
-            lastHumid = reading.humidity;
-            strncpy(lastReadingTimeStr, timeBuffer, sizeof(lastReadingTimeStr) - 1);
-            lastReadingTimeStr[sizeof(lastReadingTimeStr) - 1] = '\0';
-            mqttSendFloat(temperatureTopic, reading.temperature);
-            mqttSendFloat(humidityTopic,    reading.humidity);
-        }
+    if (isBatteryBoard()) {
+        wakeProfileEnter(WAKE_SENSORS); // publishes below are interleaved with reads
     }
 
     // Read and publish battery voltage
     // Skip if voltage rose since last reading — indicates board is charging/plugged in.
     batteryMessage[0] = '\0';
-    if (boardConfig.isBatteryPowered && boardConfig.battPin > 0) {
+    if (isBatteryBoard() && boardConfig.battPin > 0) {
         float prevVolts = lastVolts;  // RTC value from previous wake (0 on first boot)
         lastVolts = readBatteryVoltage();
         bool likelyCharging = (prevVolts > 0.0f) && (lastVolts - prevVolts > BATT_RISING_DELTA_V);
         if (!likelyCharging) {
-            snprintf(batteryMessage, sizeof(batteryMessage), " | Bat: %.2fV", lastVolts);
+            float soc  = batterySocPercent(lastVolts);
+            float days = batteryDaysLeft(soc);
+            int n = snprintf(batteryMessage, sizeof(batteryMessage), " | Bat: %.2fV %.0f%%", lastVolts, soc);
+            if (!isnan(days) && n > 0 && (size_t)n < sizeof(batteryMessage)) {
+                snprintf(batteryMessage + n, sizeof(batteryMessage) - n, " %.0fd", days);
+            }
             mqttSendFloat(batteryTopic, lastVolts);
+            if (!isnan(soc))  mqttSendFloat(batterySocTopic, soc);
+            if (!isnan(days)) mqttSendFloat(batteryDaysTopic, days);
         }
     }
 
-    // Send temperature/humidity summary debug message
-    if ((boardConfig.sensors & SENSOR_DHT) || (boardConfig.sensors & SENSOR_SHT40)) {
-        char mqttMessage[256];
-        snprintf(mqttMessage, sizeof(mqttMessage), "%s | T: %.1f | H: %.0f%s | Boot: %d | Success: %d",
-                 timeBuffer, lastTemp, lastHumid, batteryMessage, bootCount, successCount);
-        debugMessage(mqttMessage, true);
-    }
-
-    // Read PMS5003 on its own 5-minute cycle to preserve laser lifespan
-    if ((boardConfig.sensors & SENSOR_PMS5003) &&
-            (millis() - lastPmsReadMs >= PMS5003_READ_INTERVAL_MS)) {
-        Pms5003Data pms = readPms5003();
-        lastPmsReadMs = millis(); // reset interval regardless of success/fail
-        if (!pms.success) {
-            debugMessage("PMS5003 read failed.", false);
-        } else {
-            lastPmsData = pms;
-            mqttSendFloat(pm1Topic,  pms.pm1);
-            mqttSendFloat(pm25Topic, pms.pm25);
-            mqttSendFloat(pm10Topic, pms.pm10);
-            snprintf(debugBuf, sizeof(debugBuf),
-                     "%s | PM1: %.0f | PM2.5: %.0f | PM10: %.0f | CF1 PM1: %.0f | CF1 PM2.5: %.0f | CF1 PM10: %.0f",
-                     timeBuffer, pms.pm1, pms.pm25, pms.pm10, pms.pm1Std, pms.pm25Std, pms.pm10Std);
-            debugMessage(debugBuf, false);
+    // Read every driver that is due (PMS5003 runs on its own longer interval
+    // to preserve laser lifespan). Temperature/humidity go to fusion.
+    fusionReset();
+    for (uint8_t i = 0; i < driverCount(); i++) {
+        if (!driverDue(i)) continue;
+        const SensorDriver& d = driverAt(i);
+        DriverReading reading;
+        if (!driverRead(i, reading)) {
+            snprintf(debugBuf, sizeof(debugBuf), "%s %s read failed.", timeBuffer, d.name);
+            debugMessage(debugBuf, d.required);
+            if (d.required && isBatteryBoard()) {
+                deepSleep(boardConfig.timeToSleep);
+            }
+            // On mains boards: log and continue — the other drivers are still read
+            continue;
         }
-        // Power off after read to preserve laser lifespan
-        if (boardConfig.pmsPowerPin >= 0 && !boardConfig.isBatteryPowered) {
-            digitalWrite(boardConfig.pmsPowerPin, LOW);
-            pmsPoweredOn = false;
+        driverPublish(i, reading, timeBuffer);
+    }
+
+    // Publish one fused temperature/humidity value for the cycle
+    FusedClimate climate = fusionResult();
+    if (climate.success) {
+        webStateLock();
+        lastTemp  = climate.temperature;
+        lastHumid = climate.humidity;
+        strncpy(lastReadingTimeStr, timeBuffer, sizeof(lastReadingTimeStr) - 1);
+        lastReadingTimeStr[sizeof(lastReadingTimeStr) - 1] = '\0';
+        webDataChanged();
+        webStateUnlock();
+        mqttSendFloat(temperatureTopic, climate.temperature);
+        mqttSendFloat(humidityTopic,    climate.humidity);
+        historyRecord(HIST_TEMP,  climate.temperature);
+        historyRecord(HIST_HUMID, climate.humidity);
+        for (uint8_t src = 0; src < CLIMATE_SOURCE_COUNT; src++) {
+            if (!(climate.rejected & (1 << src))) continue;
+            snprintf(debugBuf, sizeof(debugBuf), "%s | %s T/H rejected as outlier", timeBuffer,
+                     fusionSourceName((ClimateSource)src));
+            debugMessage(debugBuf, false);
         }
     }
 
-    // Read SCD41 CO2 sensor if present
-    if (boardConfig.sensors & SENSOR_SCD41) {
-        Scd41Data scd = readScd41();
-        if (!scd.success) {
-            debugMessage("SCD41 read failed.", false);
-        } else {
-            lastScd41Data = scd;
-            mqttSendFloat(co2Topic, scd.co2);
-            // SCD41 is preferred for temperature and humidity; also used as fallback if no DHT
-            lastTemp  = scd.temperature;
-            lastHumid = scd.humidity;
-            strncpy(lastReadingTimeStr, timeBuffer, sizeof(lastReadingTimeStr) - 1);
-            lastReadingTimeStr[sizeof(lastReadingTimeStr) - 1] = '\0';
-            mqttSendFloat(temperatureTopic, scd.temperature);
-            mqttSendFloat(humidityTopic,    scd.humidity);
-            snprintf(debugBuf, sizeof(debugBuf), "%s | CO2: %.0f ppm | T: %.1f | H: %.0f",
-                     timeBuffer, scd.co2, scd.temperature, scd.humidity);
-            debugMessage(debugBuf, false);
+    // Battery boards: choose the next sleep from this wake's readings
+    uint16_t nextSleep = boardConfig.timeToSleep;
+    if (isBatteryBoard()) {
+        nextSleep = sleepAdaptNext(climate.success ? climate.temperature : NAN,
+                                   climate.success ? climate.humidity : NAN,
+                                   driverValue("co2"), lastVolts);
+        mqttSendFloat(sleepTopic, nextSleep);
+    }
+
+    // Send temperature/humidity summary debug message
+    if (driversHaveClimate()) {
+        char mqttMessage[256];
+        char awakeMessage[128] = "";
+        if (isBatteryBoard() && wakeProfileLastAwakeMs() > 0) {
+            char profile[120];
+            wakeProfileSummary(profile, sizeof(profile));
+            snprintf(awakeMessage, sizeof(awakeMessage), " | %s", profile);
+        }
+        char wakeMessage[80] = "";
+        if (isBatteryBoard()) {
+            uint32_t cold, warm;
+            driversBootCounts(cold, warm);
+            snprintf(wakeMessage, sizeof(wakeMessage), " %s (cold %lu/warm %lu) | Sleep: %us (%s)",
+                     driversWarmBoot() ? "warm" : "cold", (unsigned long)cold, (unsigned long)warm,
+                     nextSleep, sleepReasonName(sleepAdaptReason()));
         }
+        snprintf(mqttMessage, sizeof(mqttMessage), "%s | T: %.1f | H: %.0f%s | Boot: %d%s | Success: %d%s",
+                 timeBuffer, lastTemp, lastHumid, batteryMessage, bootCount, wakeMessage, successCount, awakeMessage);
+        debugMessage(mqttMessage, true);
     }
 
-    // Read JSY-MK-194G AC power meter if present
-    if (boardConfig.sensors & SENSOR_JSY194G) {
-        Jsy194gData jsy = readJsy194g();
+    // JSY-MK-194G AC power meter: close the sampling interval with a fresh
+    // sample and publish its statistics. V/I/P topics carry the interval mean
+    // of the ~1 Hz background samples rather than a single snapshot.
+    if (hasSensor(SENSOR_JSY194G)) {
+        jsySampleNow();
+        JsyInterval iv;
+        jsyTakeInterval(iv);
+        const Jsy194gData& jsy = iv.last;
+        const JsyChannel&  ch1 = jsy.ch[0];
+        const JsyChannel&  ch2 = jsy.ch[1];
         if (!jsy.success) {
             debugMessage("JSY-MK-194G read failed.", false);
         } else {
-            lastJsyData = jsy;
-            mqttSendFloat(jsyVoltageTopic, jsy.voltage);
-            mqttSendFloat(jsyCurrentTopic, jsy.current);
-            mqttSendFloat(jsyPowerTopic,   jsy.power);
-            mqttSendFloat(jsyPfTopic,      jsy.powerFactor);
+            // /data takes the JSY values once per publish, not per 1 Hz sample,
+            // so its ETag holds between publishes
+            webStateLock();
+            webDataChanged();
+            webStateUnlock();
+            historyRecord(HIST_POWER, iv.power.mean);
+            mqttSendFloat(jsyVoltageTopic, iv.voltage.mean);
+            mqttSendFloat(jsyCurrentTopic, iv.current.mean);
+            mqttSendFloat(jsyPowerTopic,   iv.power.mean);
+            mqttSendFloat(jsyPfTopic,      ch1.powerFactor);
             mqttSendFloat(jsyFreqTopic,    jsy.frequency);
-            mqttSendFloat(jsyEnergyTopic,  jsy.energy);
-
-            // Daily kWh delta — only published when NTP time is valid
-            float dailyKwh = 0.0f;
+            mqttSendFloat(jsyEnergyTopic,  ch1.energy);
+            mqttSendFloat(jsyDirectionTopic, ch1.exporting ? 1.0f : 0.0f);
+            mqttSendFloat(jsyIntervalEnergyTopic, iv.energyWh);
+
+            // Channel 2 — snapshot from the same bulk read
+            mqttSendFloat(jsy2VoltageTopic,   ch2.voltage);
+            mqttSendFloat(jsy2CurrentTopic,   ch2.current);
+            mqttSendFloat(jsy2PowerTopic,     ch2.power);
+            mqttSendFloat(jsy2PfTopic,        ch2.powerFactor);
+            mqttSendFloat(jsy2EnergyTopic,    ch2.energy);
+            mqttSendFloat(jsy2DirectionTopic, ch2.exporting ? 1.0f : 0.0f);
+
+            mqttClient.beginMessage(jsyStatsTopic);
+            mqttClient.printf("{\"n\":%lu,\"s\":%lu,"
+                              "\"v\":[%.1f,%.1f,%.1f,%.2f],"
+                              "\"i\":[%.2f,%.2f,%.2f,%.3f],"
+                              "\"p\":[%.1f,%.1f,%.1f,%.1f],\"wh\":%.3f}",
+                              (unsigned long)iv.power.n, (unsigned long)(iv.durationMs / 1000),
+                              iv.voltage.min, iv.voltage.max, iv.voltage.mean, runningStdDev(iv.voltage),
+                              iv.current.min, iv.current.max, iv.current.mean, runningStdDev(iv.current),
+                              iv.power.min,   iv.power.max,   iv.power.mean,   runningStdDev(iv.power),
+                              iv.energyWh);
+            mqttClient.endMessage();
+
+            // Hourly/daily/monthly rollups (persisted in NVS) — only when NTP time is valid
+            EnergyTotals totals = {};
             if (timeValid) {
-                int todayYday = timeinfo.tm_yday;
-                if (lastTmYday == -1 || todayYday != lastTmYday) {
-                    dayStartEnergy = jsy.energy;
-                    lastTmYday     = todayYday;
-                }
-                dailyKwh = jsy.energy - dayStartEnergy;
-                if (dailyKwh < 0.0f) dailyKwh = 0.0f; // guard against meter reset/rollover
-                mqttSendFloat(jsyDailyEnergyTopic, dailyKwh);
+                energyRollupUpdate(ch1.energy, timeinfo, totals);
+                mqttSendFloat(jsyDailyEnergyTopic,   totals.dayKwh);
+                mqttSendFloat(jsyMonthlyEnergyTopic, totals.monthKwh);
             }
             snprintf(debugBuf, sizeof(debugBuf),
-                     "%s | V: %.1fV | I: %.2fA | P: %.1fW | PF: %.2f | F: %.1fHz | E: %.3fkWh | Day: %.3fkWh",
-                     timeBuffer, jsy.voltage, jsy.current, jsy.power, jsy.powerFactor, jsy.frequency, jsy.energy, dailyKwh);
+                     "%s | V: %.1fV | I: %.2fA | P: %.1fW (%.0f-%.0f, n=%lu) | PF: %.2f | F: %.1fHz | E: %.3fkWh | Day: %.3fkWh | Ch2: %.1fW %.3fkWh%s",
+                     timeBuffer, iv.voltage.mean, iv.current.mean, iv.power.mean, iv.power.min, iv.power.max,
+                     (unsigned long)iv.power.n, ch1.powerFactor, jsy.frequency, ch1.energy, totals.dayKwh,
+                     ch2.power, ch2.energy, ch2.exporting ? " export" : "");
             debugMessage(debugBuf, false);
         }
     }
 
+    // Status page subscribers get the cycle's readings, JSY publish
+    // included, in one event — where the /data version was bumped
+    webPushReadings();
+
     // Process any ESP-NOW packets that arrived during this cycle's sensor reads
-    if (boardConfig.isEspNowGateway) {
+    if (isEspNowGateway()) {
         handleEspNowReceived();
         espNowGatewayTick();
     }
 
-    if (boardConfig.isBatteryPowered) {
+    if (isBatteryBoard()) {
+        metricsTick();
+        wakeProfileEnter(WAKE_ACK);
         delay(1000); // Allow messages to transmit before sleeping
-        deepSleep(boardConfig.timeToSleep);
+        deepSleep(nextSleep); // records PHASE_CYCLE as the whole wake
+    } else {
+        metricsRecord(PHASE_CYCLE, millis() - lastReadingTime);
     }
 }
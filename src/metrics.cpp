@@ -0,0 +1,398 @@
+#include "metrics.h"
+#include "drivers.h"
+#include "espnow.h"
+#include "network.h"
+#include "ota.h"
+#include "web_events.h"
+#include <WiFi.h>
+#include <esp_timer.h>
+
+RTC_DATA_ATTR static PhaseStats phaseStats[PHASE_COUNT];
+static portMUX_TYPE             phaseStatsMux = portMUX_INITIALIZER_UNLOCKED; // loop() and the web task record
+
+static const char* const phaseNames[PHASE_COUNT] = {
+    "wifi", "mqtt", "ota", "dht", "sht40", "scd41", "pms", "jsy", "modbus", "espnow", "publish", "http", "cycle",
+};
+
+static uint8_t bucketFor(uint32_t ms) {
+    uint8_t b = 0;
+    while (ms > 0 && b < PHASE_BUCKETS - 1) {
+        ms >>= 1;
+        b++;
+    }
+    return b;
+}
+
+void metricsRecord(CyclePhase phase, uint32_t ms) {
+    if (phase >= PHASE_COUNT) return;
+    uint8_t b = bucketFor(ms);
+    portENTER_CRITICAL(&phaseStatsMux);
+    PhaseStats& s = phaseStats[phase];
+    if (s.count == 0 || ms < s.minMs) s.minMs = ms;
+    if (ms > s.maxMs) s.maxMs = ms;
+    s.count++;
+    s.totalMs += ms;
+    s.buckets[b]++;
+    portEXIT_CRITICAL(&phaseStatsMux);
+}
+
+PhaseStats metricsPhase(CyclePhase phase) {
+    portENTER_CRITICAL(&phaseStatsMux);
+    PhaseStats s = phaseStats[phase < PHASE_COUNT ? phase : 0];
+    portEXIT_CRITICAL(&phaseStatsMux);
+    return s;
+}
+
+const char* metricsPhaseName(CyclePhase phase) {
+    return phase < PHASE_COUNT ? phaseNames[phase] : "?";
+}
+
+uint32_t metricsPercentileMs(CyclePhase phase, float fraction) {
+    const PhaseStats s = metricsPhase(phase);
+    uint32_t total = 0;
+    for (uint8_t b = 0; b < PHASE_BUCKETS; b++) total += s.buckets[b];
+    if (total == 0) return 0;
+    uint32_t target = (uint32_t)ceilf(total * fraction);
+    uint32_t seen   = 0;
+    for (uint8_t b = 0; b < PHASE_BUCKETS; b++) {
+        seen += s.buckets[b];
+        if (seen >= target) {
+            uint32_t upper = (b == 0) ? 0 : ((1UL << b) - 1);
+            return upper < s.maxMs ? upper : s.maxMs;
+        }
+    }
+    return s.maxMs;
+}
+
+// One small retained message per phase on {metricsTopic}/{phase}, e.g.
+//   {"n":42,"min":812,"max":4120,"mean":1290,"p90":2047,"h":[0,0,...]}
+// Kept per phase so each message fits the MQTT client's TX buffer.
+void metricsPublish() {
+    if (!mqttClient.connected()) return;
+    char topic[TOPIC_BUF_LEN + 16];
+    for (uint8_t p = 0; p < PHASE_COUNT; p++) {
+        const PhaseStats s = metricsPhase((CyclePhase)p);
+        if (s.count == 0) continue;
+        snprintf(topic, sizeof(topic), "%s/%s", metricsTopic, phaseNames[p]);
+        mqttClient.beginMessage(topic, true);
+        mqttClient.printf("{\"n\":%lu,\"min\":%lu,\"max\":%lu,\"mean\":%lu,\"p90\":%lu,\"h\":[",
+                          (unsigned long)s.count, (unsigned long)s.minMs, (unsigned long)s.maxMs,
+                          (unsigned long)(s.totalMs / s.count),
+                          (unsigned long)metricsPercentileMs((CyclePhase)p, 0.9f));
+        for (uint8_t b = 0; b < PHASE_BUCKETS; b++) {
+            mqttClient.printf(b ? ",%lu" : "%lu", (unsigned long)s.buckets[b]);
+        }
+        mqttClient.print("]}");
+        mqttClient.endMessage();
+    }
+}
+
+// Publish on a fixed schedule: every METRICS_PUBLISH_INTERVAL_MS on mains
+// boards, every METRICS_PUBLISH_EVERY_WAKES wakes on battery boards.
+void metricsTick() {
+    if (isBatteryBoard()) {
+        if (bootCount % METRICS_PUBLISH_EVERY_WAKES == 0) metricsPublish();
+        return;
+    }
+    static unsigned long lastPublishMs = 0;
+    if (lastPublishMs == 0 || millis() - lastPublishMs >= METRICS_PUBLISH_INTERVAL_MS) {
+        metricsPublish();
+        lastPublishMs = millis();
+    }
+}
+
+// ── /metrics (Prometheus text exposition format) ──────────────────────────
+// Streamed through a ChunkWriter, so the body is never built in one String.
+// Every series carries the room label; values that have no reading yet are
+// left out rather than exported as NaN.
+
+static void promHelp(ChunkWriter& w, const char* name, const char* type, const char* help) {
+    w.printf("# HELP klaussometer_%s %s\n# TYPE klaussometer_%s %s\n", name, help, name, type);
+}
+
+// klaussometer_{name}{room="...",{labels}} — the value follows
+static void promSeries(ChunkWriter& w, const char* name, const char* labels) {
+    w.printf("klaussometer_%s{room=\"%s\"%s%s} ", name, boardConfig.roomName, *labels ? "," : "", labels);
+}
+
+static void promCount(ChunkWriter& w, const char* name, const char* labels, uint32_t value) {
+    promSeries(w, name, labels);
+    w.printf("%lu\n", (unsigned long)value);
+}
+
+static void promGauge(ChunkWriter& w, const char* name, const char* labels, double value, uint8_t decimals) {
+    if (isnan(value)) return;
+    promSeries(w, name, labels);
+    w.printf("%.*f\n", decimals, value);
+}
+
+// Cumulative log2 buckets: bucket b ends at 2^b - 1 ms (bucket 0 at 0 ms),
+// the open-ended last bucket becomes +Inf.
+static void promPhaseHistogram(ChunkWriter& w) {
+    promHelp(w, "phase_duration_seconds", "histogram", "Cycle phase latency since power-on");
+    char labels[48];
+    for (uint8_t p = 0; p < PHASE_COUNT; p++) {
+        const PhaseStats s = metricsPhase((CyclePhase)p); // buckets and count agree
+        if (s.count == 0) continue;
+        uint32_t cumulative = 0;
+        for (uint8_t b = 0; b < PHASE_BUCKETS - 1; b++) {
+            cumulative += s.buckets[b];
+            uint32_t upperMs = b == 0 ? 0 : (1UL << b) - 1;
+            snprintf(labels, sizeof(labels), "phase=\"%s\",le=\"%.3f\"", phaseNames[p], upperMs / 1000.0f);
+            promCount(w, "phase_duration_seconds_bucket", labels, cumulative);
+        }
+        snprintf(labels, sizeof(labels), "phase=\"%s\",le=\"+Inf\"", phaseNames[p]);
+        promCount(w, "phase_duration_seconds_bucket", labels, s.count);
+        snprintf(labels, sizeof(labels), "phase=\"%s\"", phaseNames[p]);
+        promGauge(w, "phase_duration_seconds_sum", labels, s.totalMs / 1000.0f, 3);
+        promCount(w, "phase_duration_seconds_count", labels, s.count);
+    }
+}
+
+// Per-channel JSY-MK-194G series
+struct JsyFamily {
+    const char* name;
+    const char* type;
+    const char* help;
+    uint8_t     decimals;
+};
+static const JsyFamily jsyFamilies[] = {
+    {"ac_voltage_volts",    "gauge",   "JSY-MK-194G voltage", 1},
+    {"ac_current_amps",     "gauge",   "JSY-MK-194G current", 2},
+    {"ac_power_watts",      "gauge",   "JSY-MK-194G active power, negative when exporting", 1},
+    {"ac_power_factor",     "gauge",   "JSY-MK-194G power factor", 3},
+    {"ac_energy_kwh_total", "counter", "JSY-MK-194G positive active energy register", 3},
+};
+static constexpr uint8_t JSY_FAMILY_COUNT = sizeof(jsyFamilies) / sizeof(jsyFamilies[0]);
+
+static double jsyFamilyValue(uint8_t family, const JsyChannel& ch) {
+    switch (family) {
+        case 0:  return ch.voltage;
+        case 1:  return ch.current;
+        case 2:  return ch.power;
+        case 3:  return ch.powerFactor;
+        default: return ch.energy;
+    }
+}
+
+static void promSensors(ChunkWriter& w) {
+    char  labels[64];
+    bool  hasClimate;
+    float temp, humid;
+    {
+        WebStateGuard guard;
+        hasClimate = driversHaveClimate() && strcmp(lastReadingTimeStr, "N/A") != 0;
+        temp       = lastTemp;
+        humid      = lastHumid;
+    }
+    if (hasClimate) {
+        promHelp(w, "temperature_celsius", "gauge", "Fused room temperature");
+        promGauge(w, "temperature_celsius", "", temp, 1);
+        promHelp(w, "humidity_percent", "gauge", "Fused relative humidity");
+        promGauge(w, "humidity_percent", "", humid, 0);
+    }
+
+    promHelp(w, "sensor_value", "gauge", "Latest reading of each published sensor metric");
+    for (uint8_t i = 0; i < driverCount(); i++) {
+        const SensorDriver&  d = driverAt(i);
+        const DriverReading  r = driverLastReading(i);
+        if (!r.success) continue;
+        for (uint8_t m = 0; m < d.metricCount; m++) {
+            const MetricDescriptor& md = d.metrics[m];
+            if (md.role != ROLE_PUBLISH) continue;
+            snprintf(labels, sizeof(labels), "sensor=\"%s\",metric=\"%s\"", d.name, md.key);
+            promGauge(w, "sensor_value", labels, r.values[m], md.decimals);
+        }
+    }
+
+    promHelp(w, "sensor_reads_total", "counter", "Sensor read attempts since boot");
+    for (uint8_t i = 0; i < driverCount(); i++) {
+        uint32_t ok, failed;
+        driverReadStats(i, ok, failed);
+        snprintf(labels, sizeof(labels), "sensor=\"%s\",result=\"ok\"", driverAt(i).name);
+        promCount(w, "sensor_reads_total", labels, ok);
+        snprintf(labels, sizeof(labels), "sensor=\"%s\",result=\"failed\"", driverAt(i).name);
+        promCount(w, "sensor_reads_total", labels, failed);
+    }
+
+    if (!hasSensor(SENSOR_JSY194G)) return;
+    Jsy194gData jsy;
+    {
+        WebStateGuard guard;
+        jsy = lastJsyData;
+    }
+    if (!jsy.success) return;
+    // Family by family: a metric's samples must follow its HELP/TYPE lines
+    for (uint8_t f = 0; f < JSY_FAMILY_COUNT; f++) {
+        const JsyFamily& fam = jsyFamilies[f];
+        promHelp(w, fam.name, fam.type, fam.help);
+        for (uint8_t c = 0; c < JSY_CHANNELS; c++) {
+            snprintf(labels, sizeof(labels), "channel=\"%u\"", c + 1);
+            promGauge(w, fam.name, labels, jsyFamilyValue(f, jsy.ch[c]), fam.decimals);
+        }
+    }
+    promHelp(w, "ac_frequency_hertz", "gauge", "JSY-MK-194G line frequency");
+    promGauge(w, "ac_frequency_hertz", "", jsy.frequency, 2);
+}
+
+static void promSystem(ChunkWriter& w) {
+    char labels[80];
+    snprintf(labels, sizeof(labels), "version=\"%s\",mac=\"%s\"", FIRMWARE_VERSION, macAddress);
+    promHelp(w, "info", "gauge", "Firmware version and MAC address");
+    promCount(w, "info", labels, 1);
+    promHelp(w, "uptime_seconds", "gauge", "Time since boot");
+    promCount(w, "uptime_seconds", "", millis() / 1000);
+
+    promHelp(w, "heap_free_bytes", "gauge", "Free heap");
+    promCount(w, "heap_free_bytes", "", ESP.getFreeHeap());
+    promHelp(w, "heap_min_free_bytes", "gauge", "Lowest free heap since boot");
+    promCount(w, "heap_min_free_bytes", "", ESP.getMinFreeHeap());
+    promHelp(w, "heap_largest_block_bytes", "gauge", "Largest allocatable heap block");
+    promCount(w, "heap_largest_block_bytes", "", ESP.getMaxAllocHeap());
+
+    if (WiFi.status() == WL_CONNECTED) {
+        promHelp(w, "wifi_rssi_dbm", "gauge", "WiFi signal strength");
+        promGauge(w, "wifi_rssi_dbm", "", WiFi.RSSI(), 0);
+    }
+    const NetworkStats& net = networkStats();
+    promHelp(w, "wifi_reconnects_total", "counter", "WiFi reconnects after the link was lost");
+    promCount(w, "wifi_reconnects_total", "", net.wifiReconnects);
+    promHelp(w, "mqtt_connected", "gauge", "1 while connected to the MQTT broker");
+    promCount(w, "mqtt_connected", "", mqttLinkUp() ? 1 : 0);
+    promHelp(w, "mqtt_connects_total", "counter", "MQTT broker connect attempts");
+    promCount(w, "mqtt_connects_total", "result=\"ok\"", net.mqttConnects);
+    promCount(w, "mqtt_connects_total", "result=\"failed\"", net.mqttConnectFailures);
+    promHelp(w, "mqtt_publishes_total", "counter", "MQTT reading publishes");
+    promCount(w, "mqtt_publishes_total", "result=\"ok\"", net.mqttPublishes - net.mqttPublishFailures);
+    promCount(w, "mqtt_publishes_total", "result=\"failed\"", net.mqttPublishFailures);
+
+    if (isEspNowGateway()) {
+        EspNowGatewayStats rx = espNowGatewayStats();
+        promHelp(w, "espnow_packets_total", "counter", "ESP-NOW packets seen by the gateway");
+        promCount(w, "espnow_packets_total", "result=\"received\"", rx.received);
+        promCount(w, "espnow_packets_total", "result=\"rejected\"", rx.rejected);
+        promCount(w, "espnow_packets_total", "result=\"dropped\"", rx.dropped);
+        promHelp(w, "espnow_receiver_reinits_total", "counter", "ESP-NOW receiver re-initialisations");
+        promCount(w, "espnow_receiver_reinits_total", "", rx.reinits);
+    }
+
+    promHelp(w, "web_event_subscribers", "gauge", "Open Server-Sent Events streams");
+    promCount(w, "web_event_subscribers", "", webEventSubscribers());
+}
+
+void setupMetricsWeb() {
+    webServer.on("/metrics", HTTP_GET, []() {
+        WebRequestScope request;
+        webServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        webServer.send(200, "text/plain; version=0.0.4", "");
+        ChunkWriter w;
+        promSystem(w);
+        promSensors(w);
+        promPhaseHistogram(w);
+        w.flush();
+        webServer.sendContent("");
+    });
+}
+
+// ── Wake profiler ─────────────────────────────────────────────────────────
+
+RTC_DATA_ATTR static WakeStageStats wakeStages[WAKE_STAGE_COUNT];
+RTC_DATA_ATTR static uint32_t       wakeCount         = 0;
+RTC_DATA_ATTR static uint16_t       lastWakeAwakeMs   = 0;
+RTC_DATA_ATTR static float          meanUahPerWake    = 0.0f;
+RTC_DATA_ATTR static float          meanUahPerCycle   = 0.0f;
+RTC_DATA_ATTR static float          meanCurrentUa     = 0.0f;
+
+static const char* const wakeStageNames[WAKE_STAGE_COUNT] = { "boot", "sensors", "radio", "ack", "sleep" };
+
+// Current wake (ordinary RAM — reset on every boot)
+static WakeStage currentStage   = WAKE_BOOT;
+static bool      radioOn        = false;
+static int64_t   stageStartUs   = 0;
+static int64_t   stageUs[WAKE_STAGE_COUNT] = {};
+static double    wakeChargeUas  = 0.0; // µA·s accumulated this wake
+
+// Charge the time since the last transition to the current stage
+static void closeStage() {
+    int64_t now     = esp_timer_get_time();
+    int64_t elapsed = now - stageStartUs;
+    stageUs[currentStage] += elapsed;
+    float mA = WAKE_CURRENT_CPU_MA + (radioOn ? WAKE_CURRENT_RADIO_MA : 0.0f);
+    wakeChargeUas += (double)mA * 1000.0 * elapsed / 1000000.0;
+    stageStartUs = now;
+}
+
+void wakeProfileEnter(WakeStage stage) {
+    if (stage >= WAKE_STAGE_COUNT) return;
+    closeStage();
+    currentStage = stage;
+}
+
+void wakeProfileRadio(bool on) {
+    if (on == radioOn) return;
+    closeStage();
+    radioOn = on;
+}
+
+void wakeProfileFinish(uint32_t sleepSeconds) {
+    closeStage();
+    uint32_t awakeMs = 0;
+    for (uint8_t i = 0; i < WAKE_STAGE_COUNT; i++) {
+        uint32_t ms = (uint32_t)(stageUs[i] / 1000);
+        awakeMs += ms;
+        WakeStageStats& s = wakeStages[i];
+        s.lastMs = ms > UINT16_MAX ? UINT16_MAX : (uint16_t)ms;
+        if (s.lastMs > s.maxMs) s.maxMs = s.lastMs;
+        s.meanMs = (wakeCount == 0) ? ms : s.meanMs + WAKE_PROFILE_ALPHA * (ms - s.meanMs);
+    }
+    float wakeUah  = (float)(wakeChargeUas / 3600.0);
+    float cycleUah = wakeUah + WAKE_SLEEP_CURRENT_UA * sleepSeconds / 3600.0f;
+    float cycleS    = awakeMs / 1000.0f + sleepSeconds;
+    float currentUa = cycleS > 0.0f ? cycleUah * 3600.0f / cycleS : 0.0f;
+    if (wakeCount == 0) {
+        meanUahPerWake  = wakeUah;
+        meanUahPerCycle = cycleUah;
+        meanCurrentUa   = currentUa;
+    } else {
+        meanUahPerWake  += WAKE_PROFILE_ALPHA * (wakeUah  - meanUahPerWake);
+        meanUahPerCycle += WAKE_PROFILE_ALPHA * (cycleUah - meanUahPerCycle);
+        meanCurrentUa   += WAKE_PROFILE_ALPHA * (currentUa - meanCurrentUa);
+    }
+    lastWakeAwakeMs = awakeMs > UINT16_MAX ? UINT16_MAX : (uint16_t)awakeMs;
+    wakeCount++;
+}
+
+const WakeStageStats& wakeProfileStage(WakeStage stage) {
+    return wakeStages[stage < WAKE_STAGE_COUNT ? stage : 0];
+}
+
+uint16_t wakeProfileLastAwakeMs() {
+    return lastWakeAwakeMs;
+}
+
+float wakeProfileUahPerWake() {
+    return meanUahPerWake;
+}
+
+float wakeProfileUahPerCycle() {
+    return meanUahPerCycle;
+}
+
+float wakeProfileMeanCurrentUa() {
+    return meanCurrentUa;
+}
+
+// e.g. "Awake 2310 ms (boot 320, sensors 1510, radio 0, ack 410, sleep 70) | 78 uAh/wake, 95 uAh/cycle"
+void wakeProfileSummary(char* buf, size_t len) {
+    if (wakeCount == 0) {
+        snprintf(buf, len, "Awake: no profile yet");
+        return;
+    }
+    int n = snprintf(buf, len, "Awake %u ms (", lastWakeAwakeMs);
+    for (uint8_t i = 0; i < WAKE_STAGE_COUNT && n > 0 && (size_t)n < len; i++) {
+        n += snprintf(buf + n, len - n, "%s%s %u", i ? ", " : "", wakeStageNames[i], wakeStages[i].lastMs);
+    }
+    if (n > 0 && (size_t)n < len) {
+        snprintf(buf + n, len - n, ") | %.0f uAh/wake, %.0f uAh/cycle", meanUahPerWake, meanUahPerCycle);
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "globals.h"
+
+// ── Cycle phase latency metrics ───────────────────────────────────────────
+// Each instrumented phase accumulates count, min, max, total and a log2
+// histogram of its duration in ms. Stats live in RTC memory so battery
+// boards accumulate them across deep-sleep wakes; they reset on power-on.
+//
+// Instrument a phase at its call site:
+//   unsigned long t0 = millis();
+//   ...work...
+//   metricsRecord(PHASE_X, millis() - t0);
+enum CyclePhase : uint8_t {
+    PHASE_WIFI_CONNECT,
+    PHASE_MQTT_CONNECT,
+    PHASE_OTA_CHECK,
+    PHASE_DHT_READ,
+    PHASE_SHT40_READ,
+    PHASE_SCD41_READ,
+    PHASE_PMS_READ,
+    PHASE_JSY_READ,
+    PHASE_MODBUS_READ, // one device of the generic Modbus poller
+    PHASE_ESPNOW_SEND,
+    PHASE_PUBLISH,     // one MQTT publish (mqttSendFloat)
+    PHASE_HTTP,        // one web request, handler start to response sent
+    PHASE_CYCLE,       // mains: cycle stamp to end of loop(); battery: whole wake
+    PHASE_COUNT
+};
+
+// Bucket 0 holds 0 ms; bucket i (1..) holds [2^(i-1), 2^i) ms; the last bucket
+// is open-ended (>= 16.4 s).
+static constexpr uint8_t PHASE_BUCKETS = 16;
+
+struct PhaseStats {
+    uint32_t count;
+    uint32_t minMs;
+    uint32_t maxMs;
+    uint32_t totalMs;
+    uint32_t buckets[PHASE_BUCKETS]; // sum to count
+};
+
+void              metricsRecord(CyclePhase phase, uint32_t ms);
+PhaseStats        metricsPhase(CyclePhase phase); // consistent copy
+const char*       metricsPhaseName(CyclePhase phase);
+uint32_t          metricsPercentileMs(CyclePhase phase, float fraction); // upper bound of the bucket holding the percentile
+void              metricsPublish();
+void              metricsTick();
+void              setupMetricsWeb(); // GET /metrics, Prometheus text format
+
+// ── Wake profiler (battery boards) ────────────────────────────────────────
+// Splits each wake into stages and charges the time spent in each to an
+// estimated current, giving charge per wake. The profiler is always "in" one
+// stage: wakeProfileEnter() closes the current stage and opens the next, so
+// stages may be entered in any order and more than once. wakeProfileRadio()
+// adds the radio current on top of the CPU current while the radio is on.
+// deepSleep() calls wakeProfileFinish(), which folds the wake into rolling
+// per-stage statistics kept in RTC memory.
+// Times come from esp_timer (µs since the app started); the ROM/bootloader
+// time before that is not included.
+enum WakeStage : uint8_t {
+    WAKE_BOOT,     // app start until setup() returns
+    WAKE_SENSORS,  // sensor reads
+    WAKE_RADIO,    // radio bring-up: WiFi join, MQTT connect, OTA check
+    WAKE_ACK,      // sending data until delivery is confirmed
+    WAKE_SLEEP,    // shutdown until deep sleep starts
+    WAKE_STAGE_COUNT
+};
+
+struct WakeStageStats {
+    float    meanMs;  // exponentially weighted mean over recent wakes
+    uint16_t lastMs;
+    uint16_t maxMs;
+};
+
+void     wakeProfileEnter(WakeStage stage);
+void     wakeProfileRadio(bool on);
+void     wakeProfileFinish(uint32_t sleepSeconds);
+const WakeStageStats& wakeProfileStage(WakeStage stage);
+uint16_t wakeProfileLastAwakeMs(); // previous wake, 0 if none yet
+float    wakeProfileUahPerWake();  // rolling mean charge of the awake part (µAh)
+float    wakeProfileUahPerCycle(); // rolling mean including the following sleep (µAh)
+float    wakeProfileMeanCurrentUa(); // rolling mean current over wake + sleep (µA), 0 if none yet
+void     wakeProfileSummary(char* buf, size_t len);
+
+#endif // METRICS_H
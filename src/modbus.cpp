@@ -0,0 +1,239 @@
+#include "modbus.h"
+#include "metrics.h"
+#include "network.h"
+
+// CRC16/MODBUS (reflected polynomial 0xA001), one table lookup per byte
+static const uint16_t crcTable[256] = {
+    0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+    0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+    0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+    0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+    0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+    0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+    0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+    0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+    0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+    0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+    0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+    0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+    0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+    0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+    0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+    0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+    0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+    0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+    0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+    0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+    0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+    0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+    0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+    0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+    0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+    0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+    0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+    0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+    0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+    0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+    0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+    0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040,
+};
+
+uint16_t modbusCrc16(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc = (crc >> 8) ^ crcTable[(crc ^ data[i]) & 0xFF];
+    }
+    return crc;
+}
+
+// Response: addr(1) + FC(1) + byteCount(1) + data(registerBytes × count) + CRC(2)
+static constexpr uint8_t MODBUS_FRAME_OVERHEAD   = 5;
+static constexpr uint8_t MODBUS_EXCEPTION_BYTES  = 5;   // addr + FC|0x80 + code + CRC
+
+bool modbusReadRegisters(uint8_t slaveId, uint8_t function, uint16_t start, uint16_t count, uint16_t* out,
+                         uint8_t registerBytes) {
+    if (registerBytes != 2 && registerBytes != 4) return false;
+    const uint16_t words = count * (registerBytes / 2);
+    if (count == 0 || words > MODBUS_MAX_REGS_PER_READ) return false;
+
+    // Flush any stale bytes
+    while (Serial1.available()) Serial1.read();
+
+    uint8_t request[8];
+    request[0] = slaveId;
+    request[1] = function;
+    request[2] = start >> 8;
+    request[3] = start & 0xFF;
+    request[4] = count >> 8;
+    request[5] = count & 0xFF;
+    uint16_t crc = modbusCrc16(request, 6);
+    request[6] = crc & 0xFF;
+    request[7] = crc >> 8;
+
+    // Drive RS485 bus to transmit mode, then back to receive once sent
+    if (boardConfig.jsyDePin >= 0) {
+        digitalWrite(boardConfig.jsyDePin, HIGH);
+    }
+    Serial1.write(request, sizeof(request));
+    Serial1.flush();
+    if (boardConfig.jsyDePin >= 0) {
+        digitalWrite(boardConfig.jsyDePin, LOW);
+    }
+
+    uint8_t response[MODBUS_MAX_REGS_PER_READ * 2 + MODBUS_FRAME_OVERHEAD];
+    const int expectedBytes = words * 2 + MODBUS_FRAME_OVERHEAD;
+    int got = 0;
+    uint32_t sentMs = millis();
+    while (got < expectedBytes && millis() - sentMs < MODBUS_RESPONSE_TIMEOUT_MS) {
+        while (Serial1.available() && got < expectedBytes) {
+            response[got++] = Serial1.read();
+        }
+        // A slave exception is shorter than a normal response — stop waiting for it
+        if (got >= MODBUS_EXCEPTION_BYTES && (response[1] & 0x80)) break;
+        if (got < expectedBytes) delay(1);
+    }
+
+    if (got >= MODBUS_EXCEPTION_BYTES && response[0] == slaveId && response[1] == (function | 0x80)) {
+        Serial.printf("Modbus: slave %u exception %u at reg %u\n", slaveId, response[2], start);
+        return false;
+    }
+    if (got < expectedBytes) return false; // Timeout
+    if (response[0] != slaveId || response[1] != function || response[2] != words * 2) return false;
+
+    uint16_t respCrc = modbusCrc16(response, expectedBytes - 2);
+    if ((respCrc & 0xFF) != response[expectedBytes - 2] || (respCrc >> 8) != response[expectedBytes - 1]) {
+        return false; // CRC mismatch
+    }
+
+    for (uint16_t i = 0; i < words; i++) {
+        out[i] = ((uint16_t)response[3 + i * 2] << 8) | response[4 + i * 2];
+    }
+    return true;
+}
+
+uint8_t modbusRegisterWidth(ModbusDataType type) {
+    return (type == MODBUS_U16 || type == MODBUS_S16) ? 1 : 2;
+}
+
+float modbusDecode(const uint16_t* regs, ModbusDataType type) {
+    uint32_t raw32 = ((uint32_t)regs[0] << 16) | (modbusRegisterWidth(type) == 2 ? regs[1] : 0);
+    switch (type) {
+    case MODBUS_U16: return (float)regs[0];
+    case MODBUS_S16: return (float)(int16_t)regs[0];
+    case MODBUS_U32: return (float)raw32;
+    case MODBUS_S32: return (float)(int32_t)raw32;
+    case MODBUS_FLOAT32: {
+        float f;
+        memcpy(&f, &raw32, sizeof(f));
+        return f;
+    }
+    }
+    return NAN;
+}
+
+// ── Generic poller ────────────────────────────────────────────────────────
+
+static float         lastValues[MODBUS_MAX_DEVICES][MODBUS_MAX_REGISTERS];
+static uint8_t       deviceCount  = 0;
+static uint8_t       nextDevice   = 0;
+static unsigned long lastPollMs   = 0;
+static bool          deviceDown[MODBUS_MAX_DEVICES]; // reported as not responding
+
+void initModbusPoller() {
+    deviceCount = 0;
+    if (!hasSensor(SENSOR_MODBUS) || boardConfig.modbusDevices == nullptr) return;
+
+    deviceCount = boardConfig.modbusDeviceCount;
+    if (deviceCount > MODBUS_MAX_DEVICES) {
+        Serial.printf("CONFIG WARNING: %u Modbus devices configured, polling the first %u\n",
+                      deviceCount, MODBUS_MAX_DEVICES);
+        deviceCount = MODBUS_MAX_DEVICES;
+    }
+    for (uint8_t d = 0; d < deviceCount; d++) {
+        const ModbusDevice& dev = boardConfig.modbusDevices[d];
+        if (dev.registerCount > MODBUS_MAX_REGISTERS) {
+            Serial.printf("CONFIG WARNING: Modbus device %s has more than %u registers\n", dev.name, MODBUS_MAX_REGISTERS);
+        }
+        for (uint8_t r = 1; r < dev.registerCount && r < MODBUS_MAX_REGISTERS; r++) {
+            if (dev.registers[r].address < dev.registers[r - 1].address + modbusRegisterWidth(dev.registers[r - 1].type)) {
+                Serial.printf("CONFIG WARNING: Modbus device %s registers overlap or are not in address order\n", dev.name);
+                break;
+            }
+        }
+        for (uint8_t r = 0; r < MODBUS_MAX_REGISTERS; r++) lastValues[d][r] = NAN;
+        deviceDown[d] = false;
+    }
+}
+
+// Read one device's table using as few transactions as possible: consecutive
+// registers join the current read while the span stays within
+// MODBUS_MAX_REGS_PER_READ and the hole before them is at most
+// MODBUS_MAX_GAP_REGS. Returns the number of registers decoded.
+static uint8_t pollDevice(uint8_t d) {
+    const ModbusDevice& dev = boardConfig.modbusDevices[d];
+    const uint8_t count = dev.registerCount < MODBUS_MAX_REGISTERS ? dev.registerCount : MODBUS_MAX_REGISTERS;
+    uint16_t regs[MODBUS_MAX_REGS_PER_READ];
+    uint8_t decoded = 0;
+
+    uint8_t first = 0;
+    while (first < count) {
+        const uint16_t blockStart = dev.registers[first].address;
+        uint16_t blockEnd = blockStart + modbusRegisterWidth(dev.registers[first].type);
+        uint8_t last = first;
+        while (last + 1 < count) {
+            const ModbusRegister& next = dev.registers[last + 1];
+            uint16_t nextEnd = next.address + modbusRegisterWidth(next.type);
+            if (next.address < blockEnd || next.address - blockEnd > MODBUS_MAX_GAP_REGS ||
+                    nextEnd - blockStart > MODBUS_MAX_REGS_PER_READ) {
+                break;
+            }
+            blockEnd = nextEnd;
+            last++;
+        }
+
+        if (modbusReadRegisters(dev.slaveId, dev.function, blockStart, blockEnd - blockStart, regs)) {
+            for (uint8_t r = first; r <= last; r++) {
+                const ModbusRegister& reg = dev.registers[r];
+                float value = modbusDecode(&regs[reg.address - blockStart], reg.type);
+                lastValues[d][r] = (reg.scale != 0.0f) ? value / reg.scale : value;
+                decoded++;
+            }
+        } else {
+            for (uint8_t r = first; r <= last; r++) lastValues[d][r] = NAN;
+        }
+        first = last + 1;
+    }
+    return decoded;
+}
+
+void modbusPollTick() {
+    if (deviceCount == 0) return;
+    if (lastPollMs != 0 && millis() - lastPollMs < MODBUS_POLL_INTERVAL_MS) return;
+    lastPollMs = millis();
+
+    const uint8_t d = nextDevice;
+    nextDevice = (nextDevice + 1) % deviceCount;
+    const ModbusDevice& dev = boardConfig.modbusDevices[d];
+
+    unsigned long t0 = millis();
+    uint8_t decoded = pollDevice(d);
+    metricsRecord(PHASE_MODBUS_READ, millis() - t0);
+
+    // Report changes only: the first failed poll and the recovery
+    if ((decoded == 0) != deviceDown[d]) {
+        deviceDown[d] = (decoded == 0);
+        char buf[64];
+        snprintf(buf, sizeof(buf), "Modbus device %s (slave %u) %s", dev.name, dev.slaveId,
+                 deviceDown[d] ? "not responding" : "responding again");
+        debugMessage(buf, false);
+    }
+    if (decoded == 0) return;
+
+    if (!mqttClient.connected()) return;
+    char topic[TOPIC_BUF_LEN];
+    for (uint8_t r = 0; r < dev.registerCount && r < MODBUS_MAX_REGISTERS; r++) {
+        if (isnan(lastValues[d][r])) continue;
+        snprintf(topic, sizeof(topic), "%s%s/%s%s", MQTT_TOPIC_USER, boardConfig.roomName, dev.name, dev.registers[r].topic);
+        mqttSendFloat(topic, lastValues[d][r]);
+    }
+}
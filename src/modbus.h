@@ -0,0 +1,27 @@
+#ifndef MODBUS_H
+#define MODBUS_H
+
+#include "globals.h"
+
+// ── Modbus RTU over the RS485 bus on Serial1 ──────────────────────────────
+// modbusReadRegisters() performs one read transaction (function 0x03 or
+// 0x04) and validates address, function, length and CRC. Used by the JSY
+// driver and by the generic poller. registerBytes is the width of one
+// register address on the slave: 2 for standard Modbus, 4 for meters such
+// as the JSY-MK-194G that hold a 32-bit value per address. out receives
+// count × registerBytes / 2 words, high word first.
+//
+// The generic poller walks BoardConfig.modbusDevices round-robin: each call
+// to modbusPollTick() that is due polls one device, coalescing its register
+// table into as few reads as possible, and publishes every value to
+// {MQTT_TOPIC_USER}{room}/{device}{register topic}.
+uint16_t modbusCrc16(const uint8_t* data, size_t len);
+bool     modbusReadRegisters(uint8_t slaveId, uint8_t function, uint16_t start, uint16_t count, uint16_t* out,
+                             uint8_t registerBytes = 2);
+float    modbusDecode(const uint16_t* regs, ModbusDataType type);
+uint8_t  modbusRegisterWidth(ModbusDataType type);
+
+void     initModbusPoller();
+void     modbusPollTick();
+
+#endif // MODBUS_H
@@ -1,36 +1,65 @@
 #include "network.h"
+#include "metrics.h"
 #include "ota.h"
 #include <WiFi.h>
 
+static NetworkStats stats = {};
+// The MQTT client belongs to loop() and is not thread-safe; the web task
+// reads this copy of its state instead
+static volatile bool mqttUp = false;
+
+// Association started by startWifi() that setupWifi() has not yet waited for
+static bool          wifiBeginPending = false;
+static unsigned long wifiBeginMs      = 0;
+
+// Start association without waiting, so it proceeds while sensors power up
+// and measure. setupWifi() joins it when the network is actually needed.
+void startWifi() {
+    if (WiFi.status() == WL_CONNECTED) return;
+    wakeProfileRadio(true);
+    WiFi.mode(WIFI_STA);
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    wifiBeginMs      = millis();
+    wifiBeginPending = true;
+}
+
 bool setupWifi() {
     bool wasConnected = (WiFi.status() == WL_CONNECTED);
+    unsigned long t0  = millis();
     int counter = 1;
     while (WiFi.status() != WL_CONNECTED) {
-        debugMessage("WiFi is not OK, reconnecting", false);
         if (counter > WIFI_RETRIES) {
             snprintf(debugBuf, sizeof(debugBuf), "WiFi connection failed after %d retries.", WIFI_RETRIES);
             debugMessage(debugBuf, false);
+            wifiBeginPending = false;
             return false;
         }
-        WiFi.disconnect();
-        WiFi.mode(WIFI_STA);
-        WiFi.enableSTA(true);
-        WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-        snprintf(debugBuf, sizeof(debugBuf), "Attempt %d to connect to WiFi...", counter);
-        debugMessage(debugBuf, false);
-        delay(1000);
-        counter++;
-        if (WiFi.status() != WL_CONNECTED) {
-            delay(3000);
+        if (!wifiBeginPending) {
+            stats.wifiReconnects++;
+            wakeProfileRadio(true);
+            debugMessage("WiFi is not OK, reconnecting", false);
+            WiFi.disconnect();
+            WiFi.mode(WIFI_STA);
+            WiFi.enableSTA(true);
+            WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+            wifiBeginMs = millis();
+            snprintf(debugBuf, sizeof(debugBuf), "Attempt %d to connect to WiFi...", counter);
+            debugMessage(debugBuf, false);
+        }
+        wifiBeginPending = false; // an early start counts as the first attempt
+        while (WiFi.status() != WL_CONNECTED && millis() - wifiBeginMs < (unsigned long)WIFI_ATTEMPT_TIMEOUT_MS) {
+            delay(WIFI_POLL_INTERVAL_MS);
         }
+        counter++;
     }
 
     if (!wasConnected) {
+        metricsRecord(PHASE_WIFI_CONNECT, millis() - t0);
         Serial.print("WiFi connected. IP: ");
         Serial.println(WiFi.localIP());
     }
 
-    if (!boardConfig.isBatteryPowered) {
+    if (!isBatteryBoard()) {
         static bool webServerStarted = false;
         if (!webServerStarted) {
             setupOtaWeb();
@@ -41,6 +70,7 @@ bool setupWifi() {
 }
 
 void mqttReconnect() {
+    unsigned long t0 = millis();
     int counter = 1;
     while (!mqttClient.connected()) {
         if (counter > MQTT_RETRIES) {
@@ -50,19 +80,39 @@ void mqttReconnect() {
         }
         debugMessage("Connecting to MQTT broker...", false);
         if (mqttClient.connect(MQTT_SERVER, MQTT_PORT)) {
+            stats.mqttConnects++;
             debugMessage("MQTT link OK", false);
         } else {
+            stats.mqttConnectFailures++;
             debugMessage("[Error] MQTT not connected", false);
             delay(3000);
         }
         counter++;
     }
+    mqttUp = true;
+    metricsRecord(PHASE_MQTT_CONNECT, millis() - t0);
+}
+
+void mqttPoll() {
+    mqttClient.poll();
+    mqttUp = mqttClient.connected();
 }
 
-void mqttSendFloat(const char* topic, float value) {
-    mqttClient.beginMessage(topic);
+bool mqttLinkUp() {
+    return mqttUp;
+}
+
+void mqttSendFloat(const char* topic, float value, bool retain) {
+    unsigned long t0 = millis();
+    mqttClient.beginMessage(topic, retain);
     mqttClient.printf("%.2f", value);
-    mqttClient.endMessage();
+    stats.mqttPublishes++;
+    if (!mqttClient.endMessage()) stats.mqttPublishFailures++;
+    metricsRecord(PHASE_PUBLISH, millis() - t0);
+}
+
+const NetworkStats& networkStats() {
+    return stats;
 }
 
 void debugMessage(const char* message, bool retain) {
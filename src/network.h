@@ -3,9 +3,22 @@
 
 #include "globals.h"
 
+void startWifi();
 bool setupWifi();
 void mqttReconnect();
-void mqttSendFloat(const char* topic, float value);
+void mqttPoll();    // loop(): process incoming messages and refresh mqttLinkUp()
+bool mqttLinkUp();  // last connection state seen by loop(); safe from the web task
+void mqttSendFloat(const char* topic, float value, bool retain = false);
 void debugMessage(const char* message, bool retain);
 
+// Counters since boot, for /metrics
+struct NetworkStats {
+    uint32_t wifiReconnects;      // association attempts after the link was lost
+    uint32_t mqttConnects;        // successful broker connects
+    uint32_t mqttConnectFailures;
+    uint32_t mqttPublishes;       // mqttSendFloat() calls
+    uint32_t mqttPublishFailures; // ... whose endMessage() failed
+};
+const NetworkStats& networkStats();
+
 #endif // NETWORK_H
@@ -1,11 +1,43 @@
 #include "ota.h"
+#include "battery.h"
+#include "drivers.h"
+#include "history.h"
 #include "html.h"
+#include "metrics.h"
 #include "network.h"
+#include "web_events.h"
 #include <HTTPClient.h>
 #include <Update.h>
 #include <WiFi.h>
+#include <freertos/semphr.h>
 
-String getUptime() {
+static SemaphoreHandle_t webStateMutex = nullptr;
+
+void webStateLock() {
+    if (webStateMutex) xSemaphoreTakeRecursive(webStateMutex, portMAX_DELAY);
+}
+
+void webStateUnlock() {
+    if (webStateMutex) xSemaphoreGiveRecursive(webStateMutex);
+}
+
+WebRequestScope::~WebRequestScope() {
+    webServer.client().stop();
+    metricsRecord(PHASE_HTTP, millis() - startMs);
+}
+
+// Serves requests independently of loop(). The synchronous WebServer handles
+// one connection at a time; further clients wait in the listen backlog.
+// Handlers close each connection after its response (WebRequestScope).
+static void webServerTask(void*) {
+    for (;;) {
+        webServer.handleClient();
+        webEventsTick();
+        vTaskDelay(pdMS_TO_TICKS(WEB_TASK_POLL_INTERVAL_MS));
+    }
+}
+
+void formatUptime(char* buf, size_t len) {
     unsigned long uptimeMs = millis();
     unsigned long seconds  = uptimeMs / 1000;
 
@@ -15,9 +47,7 @@ String getUptime() {
     unsigned long remainingSeconds = seconds % 60;
 
     const char* dayLabel = (days == 1) ? " day" : " days";
-    char buffer[64];
-    snprintf(buffer, sizeof(buffer), "%lu%s, %02lu:%02lu:%02lu", days, dayLabel, hours, minutes, remainingSeconds);
-    return String(buffer);
+    snprintf(buf, len, "%lu%s, %02lu:%02lu:%02lu", days, dayLabel, hours, minutes, remainingSeconds);
 }
 
 int compareVersions(const String& v1, const String& v2) {
@@ -34,185 +64,324 @@ int compareVersions(const String& v1, const String& v2) {
     return 0;
 }
 
-// Helper: append a table row with a span-wrapped value that AJAX can update
-static void addRow(String& s, const char* label, const char* id, const String& value, const char* unit = "") {
-    s += "<tr><td><b>";
-    s += label;
-    s += ":</b></td><td><span id='";
-    s += id;
-    s += "'>";
-    s += value;
-    s += "</span>";
-    if (unit[0]) { s += " "; s += unit; }
-    s += "</td></tr>";
+// Helper: write a table row with a span-wrapped value that AJAX can update
+static void addRow(ChunkWriter& w, const char* label, const char* id, const char* value, const char* unit = "") {
+    w.printf("<tr><td><b>%s:</b></td><td><span id='%s'>%s</span>%s%s</td></tr>",
+             label, id, value, unit[0] ? " " : "", unit);
+}
+
+// Numeric row; NAN shows "N/A" without a unit
+static void addRow(ChunkWriter& w, const char* label, const char* id, float value, uint8_t decimals, const char* unit) {
+    char text[24];
+    if (isnan(value)) {
+        addRow(w, label, id, "N/A");
+        return;
+    }
+    snprintf(text, sizeof(text), "%.*f", decimals, value);
+    addRow(w, label, id, text, unit);
+}
+
+// ── OTA exclusion ─────────────────────────────────────────────────────────
+// The web upload (web task) and the pull update (loop()) share the global
+// Update object. Whichever starts first owns it until it ends; the other
+// backs off.
+static bool         otaBusy       = false;
+static portMUX_TYPE otaMux        = portMUX_INITIALIZER_UNLOCKED;
+static bool         uploadOwnsOta = false; // web task only: the current upload holds the claim
+
+static bool otaClaim() {
+    portENTER_CRITICAL(&otaMux);
+    bool claimed = !otaBusy;
+    otaBusy      = true;
+    portEXIT_CRITICAL(&otaMux);
+    return claimed;
+}
+
+static void otaRelease() {
+    portENTER_CRITICAL(&otaMux);
+    otaBusy = false;
+    portEXIT_CRITICAL(&otaMux);
+}
+
+// ── /data snapshot ────────────────────────────────────────────────────────
+// The JSON is serialised once per change of the readings it shows, on the
+// first /data request after webDataChanged(). dataVersion is bumped by the
+// writers (under the web state lock) when readings are published — a driver
+// read, the cycle's fused climate, a JSY publish, not the 1 Hz JSY samples —
+// and doubles as the ETag. Uptime is not part of it — the page advances that
+// itself.
+static uint32_t dataVersion         = 1;
+static uint32_t dataSnapshotVersion = 0;
+static char     dataSnapshot[WEB_DATA_SNAPSHOT_LEN];
+static size_t   dataSnapshotLen     = 0;
+
+void webDataChanged() {
+    dataVersion++;
+}
+
+static void snapshotAppend(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+static void snapshotAppend(const char* fmt, ...) {
+    if (dataSnapshotLen >= sizeof(dataSnapshot)) return;
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(dataSnapshot + dataSnapshotLen, sizeof(dataSnapshot) - dataSnapshotLen, fmt, args);
+    va_end(args);
+    if (n > 0) dataSnapshotLen += n;
+    if (dataSnapshotLen >= sizeof(dataSnapshot)) dataSnapshotLen = sizeof(dataSnapshot) - 1;
+}
+
+// ,"key":value — or "N/A" for NAN
+static void snapshotNumber(const char* key, float value, uint8_t decimals) {
+    if (isnan(value)) snapshotAppend(",\"%s\":\"N/A\"", key);
+    else              snapshotAppend(",\"%s\":%.*f", key, decimals, value);
+}
+
+static void buildDataSnapshot() {
+    dataSnapshotLen = 0;
+    snapshotAppend("{\"version\":\"%s\",\"eventsPort\":%u,\"time\":\"%s\"",
+                   FIRMWARE_VERSION, (unsigned)WEB_EVENTS_PORT, lastReadingTimeStr);
+
+    // Temperature / Humidity
+    bool hasClimate = driversHaveClimate() && strcmp(lastReadingTimeStr, "N/A") != 0;
+    snapshotNumber("temperature", hasClimate ? lastTemp  : NAN, 1);
+    snapshotNumber("humidity",    hasClimate ? lastHumid : NAN, 0);
+
+    // Battery
+    float soc = batterySocPercent(lastVolts);
+    snapshotAppend(",\"voltage\":%.2f", lastVolts);
+    snapshotNumber("soc",      soc, 0);
+    snapshotNumber("battDays", batteryDaysLeft(soc), 0);
+
+    // Registry drivers
+    for (uint8_t i = 0; i < driverCount(); i++) {
+        const SensorDriver&  d = driverAt(i);
+        const DriverReading  r = driverLastReading(i);
+        for (uint8_t m = 0; m < d.metricCount; m++) {
+            const MetricDescriptor& md = d.metrics[m];
+            if (md.role != ROLE_PUBLISH) continue;
+            snapshotNumber(md.key, r.success ? r.values[m] : NAN, md.decimals);
+        }
+    }
+
+    // JSY-MK-194G
+    bool ok = lastJsyData.success;
+    const JsyChannel& ch1 = lastJsyData.ch[0];
+    const JsyChannel& ch2 = lastJsyData.ch[1];
+    snapshotNumber("acVoltage",  ok ? ch1.voltage     : NAN, 1);
+    snapshotNumber("acCurrent",  ok ? ch1.current     : NAN, 2);
+    snapshotNumber("acPower",    ok ? ch1.power       : NAN, 1);
+    snapshotNumber("acPf",       ok ? ch1.powerFactor : NAN, 3);
+    snapshotNumber("acFreq",     ok ? lastJsyData.frequency : NAN, 2);
+    snapshotNumber("acEnergy",   ok ? ch1.energy      : NAN, 3);
+    snapshotAppend(",\"acDir\":\"%s\"", !ok ? "N/A" : ch1.exporting ? "Export" : "Import");
+    snapshotNumber("ac2Current", ok ? ch2.current     : NAN, 2);
+    snapshotNumber("ac2Power",   ok ? ch2.power       : NAN, 1);
+    snapshotNumber("ac2Energy",  ok ? ch2.energy      : NAN, 3);
+    snapshotAppend(",\"ac2Dir\":\"%s\"}", !ok ? "N/A" : ch2.exporting ? "Export" : "Import");
+
+    dataSnapshotVersion = dataVersion;
+}
+
+size_t webDataSnapshotCopy(char* buf, size_t len, uint32_t* version) {
+    WebStateGuard guard;
+    if (dataSnapshotVersion != dataVersion) buildDataSnapshot();
+    if (version) *version = dataSnapshotVersion;
+    size_t n = dataSnapshotLen < len - 1 ? dataSnapshotLen : len - 1;
+    memcpy(buf, dataSnapshot, n);
+    buf[n] = '\0';
+    return n;
 }
 
 void setupOtaWeb() {
     webServer.on("/", HTTP_GET, []() {
-        String content;
-        content.reserve(3072);
+        WebRequestScope request;
+        const char*  marker  = strstr(info_html, "{{content}}");
+        const size_t headLen = marker ? marker - info_html : strlen(info_html);
+
+        webServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        webServer.send(200, "text/html", "");
+        ChunkWriter w;
+        w.write(info_html, headLen);
+
+        // Readings loop() may be changing, copied before anything is sent
+        char        readingTime[sizeof(lastReadingTimeStr)];
+        float       temp, humid;
+        Jsy194gData jsy;
+        {
+            WebStateGuard guard;
+            memcpy(readingTime, lastReadingTimeStr, sizeof(readingTime));
+            temp  = lastTemp;
+            humid = lastHumid;
+            jsy   = lastJsyData;
+        }
 
         // ── Device Information ──────────────────────────────────────────────
-        content += "<p class='section-title'>Device Information</p>"
-                   "<table class='data-table'>";
-        content += "<tr><td><b>Firmware Version:</b></td><td>" + String(FIRMWARE_VERSION) + "</td></tr>";
-        content += "<tr><td><b>MAC Address:</b></td><td>" + String(macAddress) + "</td></tr>";
-        content += "<tr><td><b>Room:</b></td><td>" + String(boardConfig.displayName) + "</td></tr>";
-        content += "<tr><td><b>Uptime:</b></td><td><span id='uptime'>" + getUptime() + "</span></td></tr>";
-        content += "</table>";
+        char uptime[32];
+        formatUptime(uptime, sizeof(uptime));
+        w.print("<p class='section-title'>Device Information</p>"
+                "<table class='data-table'>");
+        w.printf("<tr><td><b>Firmware Version:</b></td><td>%s</td></tr>", FIRMWARE_VERSION);
+        w.printf("<tr><td><b>MAC Address:</b></td><td>%s</td></tr>", macAddress);
+        w.printf("<tr><td><b>Room:</b></td><td>%s</td></tr>", boardConfig.displayName);
+        w.printf("<tr><td><b>Uptime:</b></td><td><span id='uptime' data-s='%lu'>%s</span></td></tr>",
+                 millis() / 1000UL, uptime);
+        w.print("</table>");
 
         // ── Supported Sensors ───────────────────────────────────────────────
-        content += "<p class='section-title'>Supported Sensors</p>"
-                   "<table class='data-table'>"
-                   "<tr><td><b>Sensor</b></td><td><b>Measures</b></td></tr>";
-        if (boardConfig.sensors & SENSOR_DHT)
-            content += "<tr><td>DHT22</td><td>Temperature &amp; Humidity</td></tr>";
-        if (boardConfig.sensors & SENSOR_SCD41)
-            content += "<tr><td>SCD41</td><td>CO&#8322; / Temperature / Humidity</td></tr>";
-        if (boardConfig.sensors & SENSOR_PMS5003)
-            content += "<tr><td>PMS5003</td><td>PM1.0 / PM2.5 / PM10</td></tr>";
-        if (boardConfig.sensors & SENSOR_JSY194G)
-            content += "<tr><td>JSY-MK-194G</td><td>AC Voltage / Current / Power</td></tr>";
-        content += "</table>";
-
-        // ── Current Readings ────────────────────────────────────────────────
-        content += "<p class='section-title'>Current Readings</p>"
-                   "<table class='data-table'>";
-        addRow(content, "Last Update", "time", String(lastReadingTimeStr));
-
-        // Temperature / Humidity (DHT or SCD41 fallback)
-        bool hasDht = (boardConfig.sensors & SENSOR_DHT) && (strcmp(lastReadingTimeStr, "N/A") != 0);
-        bool hasScdTempHumid = (boardConfig.sensors & SENSOR_SCD41) && !(boardConfig.sensors & SENSOR_DHT) && lastScd41Data.success;
-        if (hasDht || hasScdTempHumid) {
-            addRow(content, "Temperature", "temp",  String(lastTemp, 1),  "&deg;C");
-            addRow(content, "Humidity",    "humid", String(lastHumid, 0), "%");
-        } else if ((boardConfig.sensors & SENSOR_DHT) || (boardConfig.sensors & SENSOR_SCD41)) {
-            addRow(content, "Temperature", "temp",  "N/A", "");
-            addRow(content, "Humidity",    "humid", "N/A", "");
+        w.print("<p class='section-title'>Supported Sensors</p>"
+                "<table class='data-table'>"
+                "<tr><td><b>Sensor</b></td><td><b>Measures</b></td></tr>");
+        for (uint8_t i = 0; i < driverCount(); i++) {
+            const SensorDriver& d = driverAt(i);
+            w.printf("<tr><td>%s</td><td>%s</td></tr>", d.name, d.measures);
         }
+        if (hasSensor(SENSOR_JSY194G))
+            w.print("<tr><td>JSY-MK-194G</td><td>AC Voltage / Current / Power</td></tr>");
+        w.print("</table>");
 
-        // Battery
-        if (boardConfig.isBatteryPowered) {
-            String voltStr = (lastVolts > 0.0f) ? String(lastVolts, 2) : "N/A";
-            addRow(content, "Battery Voltage", "voltage", voltStr, lastVolts > 0.0f ? "V" : "");
+        // ── ESP-NOW nodes (filled by the page from live "node" events) ──────
+        if (isEspNowGateway()) {
+            w.print("<p class='section-title'>ESP-NOW Nodes</p>"
+                    "<table class='data-table' id='nodes'></table>");
         }
 
-        // SCD41 CO2
-        if (boardConfig.sensors & SENSOR_SCD41) {
-            String co2Str = lastScd41Data.success ? String((int)lastScd41Data.co2) : "N/A";
-            addRow(content, "CO&#8322;", "co2", co2Str, lastScd41Data.success ? "ppm" : "");
+        // ── Current Readings ────────────────────────────────────────────────
+        w.print("<p class='section-title'>Current Readings</p>"
+                "<table class='data-table'>");
+        addRow(w, "Last Update", "time", readingTime);
+
+        // Temperature / Humidity (fused from every climate driver)
+        if (driversHaveClimate()) {
+            bool hasClimate = strcmp(readingTime, "N/A") != 0;
+            addRow(w, "Temperature", "temp",  hasClimate ? temp  : NAN, 1, "&deg;C");
+            addRow(w, "Humidity",    "humid", hasClimate ? humid : NAN, 0, "%");
         }
 
-        // PMS5003
-        if (boardConfig.sensors & SENSOR_PMS5003) {
-            String pm1Str  = lastPmsData.success ? String((int)lastPmsData.pm1)  : "N/A";
-            String pm25Str = lastPmsData.success ? String((int)lastPmsData.pm25) : "N/A";
-            String pm10Str = lastPmsData.success ? String((int)lastPmsData.pm10) : "N/A";
-            const char* pmUnit = lastPmsData.success ? "&micro;g/m&#179;" : "";
-            addRow(content, "PM1.0",  "pm1",  pm1Str,  pmUnit);
-            addRow(content, "PM2.5",  "pm25", pm25Str, pmUnit);
-            addRow(content, "PM10",   "pm10", pm10Str, pmUnit);
+        // Battery
+        if (isBatteryBoard()) {
+            float soc = batterySocPercent(lastVolts);
+            addRow(w, "Battery Voltage", "voltage",  lastVolts > 0.0f ? lastVolts : NAN, 2, "V");
+            addRow(w, "Battery Charge",  "soc",      soc, 0, "%");
+            addRow(w, "Battery Life",    "battDays", batteryDaysLeft(soc), 0, "days");
         }
 
-        // JSY-MK-194G
-        if (boardConfig.sensors & SENSOR_JSY194G) {
-            if (lastJsyData.success) {
-                addRow(content, "AC Voltage",    "acVoltage", String(lastJsyData.voltage, 1),     "V");
-                addRow(content, "AC Current",    "acCurrent", String(lastJsyData.current, 2),     "A");
-                addRow(content, "AC Power",      "acPower",   String(lastJsyData.power, 1),       "W");
-                addRow(content, "Power Factor",  "acPf",      String(lastJsyData.powerFactor, 3), "");
-                addRow(content, "Frequency",     "acFreq",    String(lastJsyData.frequency, 2),   "Hz");
-                addRow(content, "Energy",        "acEnergy",  String(lastJsyData.energy, 3),      "kWh");
-            } else {
-                addRow(content, "AC Voltage",   "acVoltage", "N/A", "");
-                addRow(content, "AC Current",   "acCurrent", "N/A", "");
-                addRow(content, "AC Power",     "acPower",   "N/A", "");
-                addRow(content, "Power Factor", "acPf",      "N/A", "");
-                addRow(content, "Frequency",    "acFreq",    "N/A", "");
-                addRow(content, "Energy",       "acEnergy",  "N/A", "");
+        // Registry drivers (CO2, particulates, ...)
+        for (uint8_t i = 0; i < driverCount(); i++) {
+            const SensorDriver&  d = driverAt(i);
+            const DriverReading  r = driverLastReading(i);
+            for (uint8_t m = 0; m < d.metricCount; m++) {
+                const MetricDescriptor& md = d.metrics[m];
+                if (md.role != ROLE_PUBLISH) continue;
+                addRow(w, md.webLabel ? md.webLabel : md.label, md.key,
+                       r.success ? r.values[m] : NAN, md.decimals, md.unit);
             }
         }
 
-        content += "</table>";
-
-        String html;
-        html.reserve(3072);
-        html = info_html;
-        html.replace("{{content}}", content);
-        webServer.send(200, "text/html", html);
-    });
-
-    // ── /data — JSON for AJAX refresh ──────────────────────────────────────
-    webServer.on("/data", HTTP_GET, []() {
-        String json = "{";
-        json += "\"time\":\"" + String(lastReadingTimeStr) + "\",";
-        json += "\"uptime\":\"" + getUptime() + "\",";
-
-        // Temperature / Humidity
-        bool hasDhtReading = (boardConfig.sensors & SENSOR_DHT) && (strcmp(lastReadingTimeStr, "N/A") != 0);
-        bool hasScdReading = (boardConfig.sensors & SENSOR_SCD41) && !(boardConfig.sensors & SENSOR_DHT) && lastScd41Data.success;
-        if (hasDhtReading || hasScdReading) {
-            json += "\"temperature\":" + String(lastTemp, 1) + ",";
-            json += "\"humidity\":"    + String(lastHumid, 0) + ",";
-        } else {
-            json += "\"temperature\":\"N/A\",";
-            json += "\"humidity\":\"N/A\",";
+        // JSY-MK-194G
+        if (hasSensor(SENSOR_JSY194G)) {
+            bool ok = jsy.success;
+            const JsyChannel& ch1 = jsy.ch[0];
+            const JsyChannel& ch2 = jsy.ch[1];
+            addRow(w, "AC Voltage",    "acVoltage",  ok ? ch1.voltage     : NAN, 1, "V");
+            addRow(w, "AC Current",    "acCurrent",  ok ? ch1.current     : NAN, 2, "A");
+            addRow(w, "AC Power",      "acPower",    ok ? ch1.power       : NAN, 1, "W");
+            addRow(w, "Power Factor",  "acPf",       ok ? ch1.powerFactor : NAN, 3, "");
+            addRow(w, "Frequency",     "acFreq",     ok ? jsy.frequency : NAN, 2, "Hz");
+            addRow(w, "Energy",        "acEnergy",   ok ? ch1.energy      : NAN, 3, "kWh");
+            addRow(w, "Direction",     "acDir",      !ok ? "N/A" : ch1.exporting ? "Export" : "Import");
+            addRow(w, "Ch2 Current",   "ac2Current", ok ? ch2.current     : NAN, 2, "A");
+            addRow(w, "Ch2 Power",     "ac2Power",   ok ? ch2.power       : NAN, 1, "W");
+            addRow(w, "Ch2 Energy",    "ac2Energy",  ok ? ch2.energy      : NAN, 3, "kWh");
+            addRow(w, "Ch2 Direction", "ac2Dir",     !ok ? "N/A" : ch2.exporting ? "Export" : "Import");
         }
 
-        // Battery
-        json += "\"voltage\":" + String(lastVolts, 2) + ",";
+        w.print("</table>");
 
-        // SCD41 CO2
-        if (lastScd41Data.success) {
-            json += "\"co2\":" + String((int)lastScd41Data.co2) + ",";
-        } else {
-            json += "\"co2\":\"N/A\",";
+        // ── Cycle Timing ────────────────────────────────────────────────────
+        w.print("<p class='section-title'>Cycle Timing (ms)</p>"
+                "<table class='data-table'>"
+                "<tr><td><b>Phase</b></td><td><b>mean / p90 / max (n)</b></td></tr>");
+        for (uint8_t p = 0; p < PHASE_COUNT; p++) {
+            const PhaseStats s = metricsPhase((CyclePhase)p);
+            if (s.count == 0) continue;
+            w.printf("<tr><td>%s</td><td>%lu / %lu / %lu (%lu)</td></tr>",
+                     metricsPhaseName((CyclePhase)p), (unsigned long)(s.totalMs / s.count),
+                     (unsigned long)metricsPercentileMs((CyclePhase)p, 0.9f),
+                     (unsigned long)s.maxMs, (unsigned long)s.count);
         }
+        w.print("</table>");
 
-        // PMS5003
-        if (lastPmsData.success) {
-            json += "\"pm1\":"  + String((int)lastPmsData.pm1)  + ",";
-            json += "\"pm25\":" + String((int)lastPmsData.pm25) + ",";
-            json += "\"pm10\":" + String((int)lastPmsData.pm10) + ",";
-        } else {
-            json += "\"pm1\":\"N/A\",";
-            json += "\"pm25\":\"N/A\",";
-            json += "\"pm10\":\"N/A\",";
+        // ── History chart ───────────────────────────────────────────────────
+        bool anyHistory = false;
+        for (uint8_t m = 0; m < HIST_METRIC_COUNT; m++) {
+            if (!historyAvailable((HistoryMetric)m)) continue;
+            if (!anyHistory) {
+                w.print("<p class='section-title'>History (24 h)</p>"
+                        "<select id='histMetric' onchange='loadHistory()'>");
+                anyHistory = true;
+            }
+            w.printf("<option>%s</option>", historyMetricName((HistoryMetric)m));
         }
-
-        // JSY-MK-194G (last field — no trailing comma)
-        if (lastJsyData.success) {
-            json += "\"acVoltage\":" + String(lastJsyData.voltage, 1)     + ",";
-            json += "\"acCurrent\":" + String(lastJsyData.current, 2)     + ",";
-            json += "\"acPower\":"   + String(lastJsyData.power, 1)       + ",";
-            json += "\"acPf\":"      + String(lastJsyData.powerFactor, 3) + ",";
-            json += "\"acFreq\":"    + String(lastJsyData.frequency, 2)   + ",";
-            json += "\"acEnergy\":"  + String(lastJsyData.energy, 3);
-        } else {
-            json += "\"acVoltage\":\"N/A\",";
-            json += "\"acCurrent\":\"N/A\",";
-            json += "\"acPower\":\"N/A\",";
-            json += "\"acPf\":\"N/A\",";
-            json += "\"acFreq\":\"N/A\",";
-            json += "\"acEnergy\":\"N/A\"";
+        if (anyHistory) {
+            w.print("</select><canvas id='histChart' width='340' height='140'></canvas>");
         }
 
-        json += "}";
-        webServer.send(200, "application/json", json);
+        if (marker) w.print(marker + strlen("{{content}}"));
+        w.flush();
+        webServer.sendContent(""); // end of chunked response
     });
 
-    webServer.on("/update", HTTP_GET, []() {
-        String htmlPage;
-        htmlPage.reserve(1024);
-        htmlPage = ota_html;
-        htmlPage.replace("{{FIRMWARE_VERSION}}", FIRMWARE_VERSION);
-        webServer.send(200, "text/html", htmlPage);
+    // ── /data — JSON for AJAX refresh ──────────────────────────────────────
+    // Serves a copy of the cached snapshot; a poll whose If-None-Match still
+    // matches gets a header-only 304.
+    webServer.on("/data", HTTP_GET, []() {
+        WebRequestScope request;
+        char     body[WEB_DATA_SNAPSHOT_LEN];
+        uint32_t version;
+        size_t   len = webDataSnapshotCopy(body, sizeof(body), &version);
+        char etag[16];
+        snprintf(etag, sizeof(etag), "\"%lu\"", (unsigned long)version);
+        webServer.sendHeader("ETag", etag);
+        webServer.sendHeader("Cache-Control", "no-cache");
+        if (webServer.header("If-None-Match") == etag) {
+            webServer.send(304);
+            return;
+        }
+        webServer.send_P(200, "application/json", body, len);
     });
 
+    // ── Static assets (web/, gzipped at build time) ────────────────────────
+    // Sent from flash as stored. Hash-versioned URLs are cached for a year;
+    // the rest (the /update page) revalidate against the hash as ETag.
+    for (const WebAsset& asset : webAssets) {
+        const WebAsset* a = &asset;
+        webServer.on(a->url, HTTP_GET, [a]() {
+            WebRequestScope request;
+            if (a->cacheable) {
+                webServer.sendHeader("Cache-Control", "public, max-age=31536000, immutable");
+            } else {
+                webServer.sendHeader("Cache-Control", "no-cache");
+                webServer.sendHeader("ETag", "\"" WEB_ASSETS_HASH "\"");
+                if (webServer.header("If-None-Match") == "\"" WEB_ASSETS_HASH "\"") {
+                    webServer.send(304);
+                    return;
+                }
+            }
+            webServer.sendHeader("Content-Encoding", "gzip");
+            webServer.send_P(200, a->contentType, (const char*)a->gzip, a->gzipLen);
+        });
+    }
+
+    // Refused with 409 while a pull update from loop() owns Update
     webServer.on(
         "/update", HTTP_POST,
         []() {
             webServer.sendHeader("Connection", "close");
+            if (!uploadOwnsOta) {
+                webServer.send(409, "text/plain", "OTA update already in progress");
+                webServer.client().stop();
+                return;
+            }
             webServer.send(200, "text/plain", (Update.hasError()) ? "FAIL" : "OK");
             delay(1000);
             ESP.restart();
@@ -220,16 +389,24 @@ void setupOtaWeb() {
         []() {
             HTTPUpload& upload = webServer.upload();
             if (upload.status == UPLOAD_FILE_START) {
-                if (!Update.begin(UPDATE_SIZE_UNKNOWN)) {
+                uploadOwnsOta = otaClaim();
+                if (uploadOwnsOta && !Update.begin(UPDATE_SIZE_UNKNOWN)) {
                     Update.printError(Serial);
                 }
+            } else if (!uploadOwnsOta) {
+                return;
+            } else if (upload.status == UPLOAD_FILE_ABORTED) {
+                Update.abort();
+                otaRelease();
+                uploadOwnsOta = false;
             } else if (upload.status == UPLOAD_FILE_WRITE) {
                 if (Update.write(upload.buf, upload.currentSize) != upload.currentSize) {
                     Update.printError(Serial);
                 }
             } else if (upload.status == UPLOAD_FILE_END) {
                 if (Update.end(true)) {
-                    debugMessage("Update Success, rebooting...", true);
+                    // Serial only: the MQTT client belongs to loop()
+                    Serial.println("Update Success, rebooting...");
                     delay(1000);
                 } else {
                     Update.printError(Serial);
@@ -237,7 +414,18 @@ void setupOtaWeb() {
             }
         });
 
+    setupHistoryWeb();
+    setupMetricsWeb();
+    webServer.onNotFound([]() {
+        WebRequestScope request;
+        webServer.send(404, "text/plain", "Not found");
+    });
+    static const char* requestHeaders[] = {"If-None-Match"};
+    webServer.collectHeaders(requestHeaders, 1);
+    webStateMutex = xSemaphoreCreateRecursiveMutex();
     webServer.begin();
+    initWebEvents();
+    xTaskCreatePinnedToCore(webServerTask, "web", WEB_TASK_STACK_BYTES, nullptr, WEB_TASK_PRIORITY, nullptr, 0);
 }
 
 void checkForUpdates() {
@@ -245,10 +433,11 @@ void checkForUpdates() {
         debugMessage("WiFi not connected. Cannot check for updates.", false);
         return;
     }
+    unsigned long t0 = millis();
 
     HTTPClient http;
     char versionUrl[256];
-    snprintf(versionUrl, sizeof(versionUrl), "https://%s:%d%s", OTA_HOST, OTA_PORT, OTA_VERSION_PATH);
+    snprintf(versionUrl, sizeof(versionUrl), "https://%s:%d%s%s", OTA_HOST, OTA_PORT, OTA_PROFILE_PREFIX, OTA_VERSION_PATH);
     http.begin(versionUrl);
     int httpCode = http.GET();
     if (httpCode == HTTP_CODE_OK) {
@@ -264,12 +453,17 @@ void checkForUpdates() {
         debugMessage("Error fetching version file.", true);
     }
     http.end();
+    metricsRecord(PHASE_OTA_CHECK, millis() - t0);
 }
 
 void updateFirmware() {
+    if (!otaClaim()) {
+        debugMessage("Firmware upload via web UI in progress, skipping OTA update.", true);
+        return;
+    }
     HTTPClient http;
     char binUrl[256];
-    snprintf(binUrl, sizeof(binUrl), "https://%s:%d%s", OTA_HOST, OTA_PORT, OTA_BIN_PATH);
+    snprintf(binUrl, sizeof(binUrl), "https://%s:%d%s%s", OTA_HOST, OTA_PORT, OTA_PROFILE_PREFIX, OTA_BIN_PATH);
     http.begin(binUrl);
     int httpCode = http.GET();
     if (httpCode == HTTP_CODE_OK) {
@@ -299,4 +493,5 @@ void updateFirmware() {
         debugMessage(debugBuf, true);
     }
     http.end();
+    otaRelease();
 }
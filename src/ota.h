@@ -2,11 +2,82 @@
 #define OTA_H
 
 #include "globals.h"
+#include <stdarg.h>
 
 void   setupOtaWeb();
 void   checkForUpdates();
 void   updateFirmware();
-String getUptime();
+void   formatUptime(char* buf, size_t len);
 int    compareVersions(const String& v1, const String& v2);
 
+// ── Web server task (mains boards) ────────────────────────────────────────
+// setupOtaWeb() runs the web server on its own task (core 0), so the UI,
+// /data and OTA upload respond while loop() reads sensors or waits on MQTT.
+// loop() code that changes what handlers show (driver readings, fused
+// climate, history, JSY data) takes the web state lock around the change.
+// Handlers take it only to copy that state into locals, never across a
+// network send, so a slow client cannot hold up the sensor loop. The lock
+// is recursive and a no-op until the task starts, so battery boards never
+// contend for it.
+void webStateLock();
+void webStateUnlock();
+void webDataChanged(); // call with the lock held after changing a value /data shows
+
+static constexpr size_t WEB_DATA_SNAPSHOT_LEN = 1024;
+size_t webDataSnapshotCopy(char* buf, size_t len, uint32_t* version = nullptr); // current /data JSON; takes the lock
+
+struct WebStateGuard {
+    WebStateGuard() { webStateLock(); }
+    ~WebStateGuard() { webStateUnlock(); }
+};
+
+// First line of every handler: records its handling time as PHASE_HTTP and
+// closes the connection once the handler returns, so the next client is not
+// held while the WebServer waits for this one to close.
+struct WebRequestScope {
+    unsigned long startMs = millis();
+    ~WebRequestScope();
+};
+
+// Chunked response writer (status page, /metrics): pieces are gathered in a
+// small fixed buffer and sent as one chunk whenever the next piece would not fit.
+// Pieces larger than the buffer (the page template) go out directly from flash.
+struct ChunkWriter {
+    char   buf[512];
+    size_t len = 0;
+
+    void flush() {
+        if (len > 0) webServer.sendContent_P(buf, len);
+        len = 0;
+    }
+    void write(const char* s, size_t n) {
+        if (len + n > sizeof(buf)) flush();
+        if (n > sizeof(buf)) {
+            webServer.sendContent_P(s, n);
+            return;
+        }
+        memcpy(buf + len, s, n);
+        len += n;
+    }
+    void print(const char* s) { write(s, strlen(s)); }
+    void printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        for (uint8_t attempt = 0; attempt < 2; attempt++) {
+            va_start(args, fmt);
+            int n = vsnprintf(buf + len, sizeof(buf) - len, fmt, args);
+            va_end(args);
+            if (n < 0) return;
+            if (len + n < sizeof(buf)) {
+                len += n;
+                return;
+            }
+            if (len == 0) { // longer than the whole buffer: send it truncated
+                len = sizeof(buf) - 1;
+                return;
+            }
+            flush();
+        }
+    }
+};
+
 #endif // OTA_H
@@ -0,0 +1,36 @@
+#include "power.h"
+#include "network.h"
+#include <esp_timer.h>
+
+// Wake latency statistics: how much longer each idleWait() took than asked
+static uint32_t idleWaitCount    = 0;
+static uint64_t idleLatencySumUs = 0;
+static uint32_t idleLatencyMaxUs = 0;
+static unsigned long lastIdleReportMs = 0;
+
+void idleWait(uint32_t ms) {
+    int64_t start = esp_timer_get_time();
+    delay(ms);
+    int64_t lateUs = esp_timer_get_time() - start - (int64_t)ms * 1000;
+    if (lateUs < 0) lateUs = 0;
+    idleWaitCount++;
+    idleLatencySumUs += (uint64_t)lateUs;
+    if ((uint32_t)lateUs > idleLatencyMaxUs) idleLatencyMaxUs = (uint32_t)lateUs;
+}
+
+void idlePowerSummary(char* buf, size_t len) {
+    uint32_t avgUs = idleWaitCount ? (uint32_t)(idleLatencySumUs / idleWaitCount) : 0;
+    snprintf(buf, len, "Idle: wake latency avg %lu us, max %lu us over %lu waits",
+             (unsigned long)avgUs, (unsigned long)idleLatencyMaxUs, (unsigned long)idleWaitCount);
+}
+
+// Publish the summary once per IDLE_REPORT_INTERVAL_MS, then restart the window
+void idlePowerTick() {
+    if (millis() - lastIdleReportMs < IDLE_REPORT_INTERVAL_MS) return;
+    idlePowerSummary(debugBuf, sizeof(debugBuf));
+    debugMessage(debugBuf, false);
+    idleWaitCount    = 0;
+    idleLatencySumUs = 0;
+    idleLatencyMaxUs = 0;
+    lastIdleReportMs = millis();
+}
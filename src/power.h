@@ -0,0 +1,17 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include "globals.h"
+
+// ── Idle loop wake latency (mains boards) ─────────────────────────────────
+// The pinned Arduino core 1.0.6 is built without CONFIG_PM_ENABLE, so esp_pm
+// light sleep and CPU frequency scaling are unavailable, and its WiFi station
+// already runs in modem sleep. Nothing here changes the power draw.
+// Use idleWait() instead of delay() in the idle loop: it records how late
+// each wake was (wake latency).
+// Call idlePowerTick() from the idle loop to publish a periodic summary.
+void idleWait(uint32_t ms);
+void idlePowerTick();
+void idlePowerSummary(char* buf, size_t len);
+
+#endif // POWER_H
@@ -1,7 +1,10 @@
 #include "sensors.h"
+#include "modbus.h"
 #include <PMS.h>
 #include <SensirionI2cScd4x.h>
 #include <SensirionI2cSht4x.h>
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
 #include <esp_task_wdt.h>
 
 // File-scope sensor objects (Serial2 / Wire initialised by setup() before first use)
@@ -9,15 +12,36 @@ static PMS               pms(Serial2);
 static SensirionI2cScd4x scd4x;
 static SensirionI2cSht4x sht4x;
 
+static unsigned long dhtPowerOnMs = 0; // millis() when the DHT was powered; guard is measured from here
+
+// Power the DHT (GPIO power/GND pins if configured) and start its settle
+// guard. Called early in setup() so the guard overlaps WiFi association.
+void powerOnDht() {
+    if (boardConfig.dhtGndPin > 0) {
+        pinMode(boardConfig.dhtGndPin, OUTPUT);
+        digitalWrite(boardConfig.dhtGndPin, LOW);    // GPIO as GND substitute
+    }
+    if (boardConfig.dhtPowerPin > 0) {
+        pinMode(boardConfig.dhtPowerPin, OUTPUT);
+        digitalWrite(boardConfig.dhtPowerPin, HIGH); // Power on early to warm up
+    }
+    dht->begin();
+    dhtPowerOnMs = millis();
+}
+
 SensorData readDhtSensor() {
     SensorData data;
     data.temperature = NAN;
     data.humidity    = NAN;
     data.success     = false;
 
-    // Short guard to ensure DHT22 has had enough stable power before the first read,
-    // even if WiFi/NTP completed unusually fast.
-    delay(DHT_INITIAL_DELAY_MS);
+    // Ensure the DHT22 has had enough stable power before the first read. The
+    // guard runs from power-on, so only the part not already spent on other
+    // wake work (WiFi association, I2C init) is waited here.
+    unsigned long sincePowerOn = millis() - dhtPowerOnMs;
+    if (sincePowerOn < (unsigned long)DHT_INITIAL_DELAY_MS) {
+        delay(DHT_INITIAL_DELAY_MS - sincePowerOn);
+    }
 
     for (int i = 0; i < DHT_RETRIES; i++) {
         data.temperature = dht->readTemperature();
@@ -39,33 +63,53 @@ SensorData readDhtSensor() {
                       DHT_RETRIES, boardConfig.dhtDataPin);
     }
 
-    if (boardConfig.isBatteryPowered) {
+    return data;
+}
+
+// Battery boards cut DHT power between wakes
+void powerOffDht() {
+    if (isBatteryBoard() && boardConfig.dhtPowerPin > 0) {
         digitalWrite(boardConfig.dhtPowerPin, LOW);
     }
-
-    return data;
 }
 
 float readBatteryVoltage() {
-    if (!boardConfig.isBatteryPowered || boardConfig.battPin <= 0) {
+    if (!isBatteryBoard() || boardConfig.battPin <= 0) {
         return 0.0;
     }
 
-    // Configure ADC for better accuracy (12-bit width is the default, no need to set it)
-    analogSetAttenuation(ADC_11db);         // 0-3.6V range
+    // Battery pins are ADC1 (ADC2 is unavailable while WiFi is on)
+    int8_t channel = digitalPinToAnalogChannel(boardConfig.battPin);
+    if (channel < 0 || channel >= ADC1_CHANNEL_MAX) {
+        Serial.println("CONFIG WARNING: battPin is not an ADC1 pin (GPIO 32-39)");
+        return 0.0;
+    }
 
-    // Discard first reading (often inaccurate)
-    analogRead(boardConfig.battPin);
-    delay(ADC_SETTLE_DELAY_MS);
+    // eFuse calibration (two-point or Vref) corrects per-chip gain and offset
+    static esp_adc_cal_characteristics_t adcChars;
+    static bool adcCharacterised = false;
+    if (!adcCharacterised) {
+        adc1_config_width(ADC_WIDTH_BIT_12);
+        esp_adc_cal_value_t source = esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12,
+                                                              ADC_DEFAULT_VREF_MV, &adcChars);
+        if (source == ESP_ADC_CAL_VAL_DEFAULT_VREF) {
+            Serial.println("Battery: no ADC eFuse calibration on this chip, using default Vref");
+        }
+        adcCharacterised = true;
+    }
+    adc1_config_channel_atten((adc1_channel_t)channel, ADC_ATTEN_DB_11); // 0-3.6V range
 
+    // Burst: discard the first conversion after channel setup, then average
+    // back-to-back samples — no settle delays needed
+    adc1_get_raw((adc1_channel_t)channel);
     uint32_t total = 0;
-    for (int i = 0; i < VOLT_READS; i++) {
-        total += analogRead(boardConfig.battPin);
-        delay(ADC_SETTLE_DELAY_MS);
+    for (uint16_t i = 0; i < BATT_BURST_SAMPLES; i++) {
+        total += adc1_get_raw((adc1_channel_t)channel);
     }
 
-    float avgRaw = (float)total / VOLT_READS;
-    float volts  = avgRaw / RAW_VOLTS_CONVERSION;
+    uint32_t mv      = esp_adc_cal_raw_to_voltage(total / BATT_BURST_SAMPLES, &adcChars);
+    float    divider = boardConfig.battDividerFactor > 0.0f ? boardConfig.battDividerFactor : BATT_DIVIDER_DEFAULT;
+    float    volts   = mv / 1000.0f * divider;
 
     // Exponential smoothing with previous reading
     if (lastVolts > 0.0) {
@@ -76,22 +120,98 @@ float readBatteryVoltage() {
     return volts;
 }
 
-// Initialise SCD41 via the Sensirion library; called from setup()
-void initScd41(int sdaPin, int sclPin) {
+// SCD41 measurement state. scd41SampleDueMs is when the next sample is expected
+// (measurement start + mode interval); in single-shot mode readScd41() waits
+// no longer than that.
+static Scd41Mode     scd41Mode        = SCD41_MODE_PERIODIC;
+static unsigned long scd41SampleDueMs = 0;
+static Scd41Data     scd41Latched     = {}; // sample fetched by pollScd41(), not yet consumed
+
+static uint32_t scd41IntervalMs() {
+    switch (scd41Mode) {
+        case SCD41_MODE_LOW_POWER:   return SCD41_LOW_POWER_INTERVAL_MS;
+        case SCD41_MODE_SINGLE_SHOT: return SCD41_SINGLE_SHOT_MS;
+        default:                     return SCD41_PERIODIC_INTERVAL_MS;
+    }
+}
+
+// Start the shared I2C bus once, whichever I2C sensor initialises first
+static void beginI2c(int sdaPin, int sclPin) {
+    static bool started = false;
+    if (started) return;
     Wire.begin(sdaPin >= 0 ? sdaPin : SCD41_DEFAULT_SDA_PIN,
                sclPin >= 0 ? sclPin : SCD41_DEFAULT_SCL_PIN);
+    started = true;
+}
+
+// Initialise SCD41 via the Sensirion library; called from setup(). A warm
+// wake skips the stop / 500 ms / reinit sequence: the sensor stayed powered
+// and is still in the mode set on the cold boot.
+void initScd41(int sdaPin, int sclPin, Scd41Mode mode, bool warm) {
+    beginI2c(sdaPin, sclPin);
     scd4x.begin(Wire, SCD41_I2C_ADDR);
+    scd41Mode = mode;
+    if (warm) {
+        scd41SampleDueMs = millis() + scd41IntervalMs();
+        return;
+    }
     scd4x.stopPeriodicMeasurement(); // stop if already running; safe no-op on first boot
     delay(SCD41_INIT_DELAY_MS);      // must wait >= 500 ms before any other command
     scd4x.reinit();                  // restore factory settings; recovers sensor from bad state
     delay(SCD41_REINIT_DELAY_MS);
-    scd4x.startPeriodicMeasurement();
+
+    switch (mode) {
+        case SCD41_MODE_LOW_POWER:
+            scd4x.startLowPowerPeriodicMeasurement();
+            break;
+        case SCD41_MODE_SINGLE_SHOT:
+            break; // sensor stays idle until startScd41Measurement()
+        default:
+            scd4x.startPeriodicMeasurement();
+            break;
+    }
+    scd41SampleDueMs = millis() + scd41IntervalMs();
+}
+
+// Trigger a single-shot measurement without blocking. The library's
+// measureSingleShot() sleeps for the full 5 s, so the command (0x219D, no
+// arguments) is written directly and the result collected via readScd41().
+// No-op in the periodic modes, which measure continuously.
+void startScd41Measurement() {
+    if (scd41Mode != SCD41_MODE_SINGLE_SHOT) return;
+    Wire.beginTransmission(SCD41_I2C_ADDR);
+    Wire.write(0x21);
+    Wire.write(0x9D);
+    Wire.endTransmission();
+    scd41SampleDueMs = millis() + SCD41_SINGLE_SHOT_MS;
+}
+
+// Non-blocking: if the sensor reports data ready, fetch the sample and latch it
+// for the next readScd41(). Safe to call often; returns true when a new sample
+// was latched. The sensor NACKs while a single-shot is running, which reads as
+// "not ready".
+bool pollScd41() {
+    bool isDataReady = false;
+    if (scd4x.getDataReadyStatus(isDataReady) || !isDataReady) return false;
+
+    uint16_t co2 = 0;
+    float    temperature = 0.0f;
+    float    humidity    = 0.0f;
+    if (scd4x.readMeasurement(co2, temperature, humidity) || co2 == 0) return false;
+
+    scd41Latched.co2         = co2;
+    scd41Latched.temperature = temperature;
+    scd41Latched.humidity    = humidity;
+    scd41Latched.success     = true;
+    if (scd41Mode != SCD41_MODE_SINGLE_SHOT) {
+        scd41SampleDueMs = millis() + scd41IntervalMs();
+    }
+    return true;
 }
 
 // Initialise SHT40 via the Sensirion library; called from setup()
 void initSht40(int sdaPin, int sclPin) {
-    Wire.begin(sdaPin >= 0 ? sdaPin : SCD41_DEFAULT_SDA_PIN,
-               sclPin >= 0 ? sclPin : SCD41_DEFAULT_SCL_PIN);
+    beginI2c(sdaPin, sclPin);
     sht4x.begin(Wire, SHT40_I2C_ADDR);
 }
 
@@ -108,15 +228,59 @@ SensorData readSht40() {
     return data;
 }
 
+// Passive mode and UART sleep/wake are commands to the sensor: without
+// pmsTxPin it stays in active mode, streaming frames
+static bool pmsCanCommand() {
+    return boardConfig.pmsTxPin >= 0;
+}
+
+// Start the PMS5003 UART (Serial2) and power the sensor up
+void initPms5003() {
+    Serial2.begin(9600, SERIAL_8N1, boardConfig.pmsRxPin, boardConfig.pmsTxPin);
+    if (boardConfig.pmsPowerPin >= 0) {
+        pinMode(boardConfig.pmsPowerPin, OUTPUT);
+    }
+    if (!pmsCanCommand()) {
+        Serial.println(boardConfig.pmsPowerPin >= 0
+                           ? "CONFIG WARNING: PMS5003 has no pmsTxPin — passive mode and UART sleep unavailable, reading streamed frames"
+                           : "CONFIG WARNING: PMS5003 has no pmsTxPin or pmsPowerPin — sensor runs continuously, reading streamed frames");
+    }
+    setPmsPower(true);
+}
+
+// Wake or sleep the PMS5003 to preserve laser lifespan. With pmsPowerPin the
+// supply is switched; otherwise the UART sleep/wake commands stop the fan and
+// laser, and with neither the sensor runs continuously. Either way the sensor
+// comes back in active mode — readPms5003() switches it to passive before
+// requesting a frame when it can.
+void setPmsPower(bool on) {
+    if (boardConfig.pmsPowerPin >= 0) {
+        digitalWrite(boardConfig.pmsPowerPin, on ? HIGH : LOW);
+    } else if (!pmsCanCommand()) {
+        return;
+    } else if (on) {
+        pms.wakeUp();
+    } else {
+        pms.sleep();
+    }
+}
+
 // Read PMS5003 particulate matter sensor via the PMS library (Serial2)
 Pms5003Data readPms5003() {
     Pms5003Data data = {};
 
-    // Discard stale buffered frames so we read the freshest available sample
+    // Passive mode: the sensor stops streaming and sends one frame on request.
+    // Drop the streamed frames and the mode command's ack before asking.
+    // Without TX, drop the buffered frames and take the next one streamed.
+    if (pmsCanCommand()) {
+        pms.passiveMode();
+        delay(PMS5003_CMD_SETTLE_MS);
+    }
     while (Serial2.available()) Serial2.read();
-
+    if (pmsCanCommand()) pms.requestRead();
     PMS::DATA pmsData;
-    if (!pms.readUntil(pmsData, PMS5003_READ_TIMEOUT_MS)) return data;
+    bool ok = pms.readUntil(pmsData, PMS5003_READ_TIMEOUT_MS);
+    if (!ok) return data;
 
     data.pm1     = pmsData.PM_AE_UG_1_0;
     data.pm25    = pmsData.PM_AE_UG_2_5;
@@ -128,109 +292,54 @@ Pms5003Data readPms5003() {
     return data;
 }
 
-// Read CO2, temperature and humidity from SCD41 via the Sensirion library
+// Return the freshest SCD41 sample: one already latched by pollScd41(), or
+// one ready now. The periodic modes never wait — the idle loop latches their
+// samples, so success=false just means no new sample since the last read.
+// A single-shot measurement is waited for until it is due (plus
+// SCD41_READY_MARGIN_MS).
 Scd41Data readScd41() {
-    Scd41Data data = {};
-
-    bool isDataReady = false;
-    if (scd4x.getDataReadyStatus(isDataReady) || !isDataReady) return data;
-
-    uint16_t co2 = 0;
-    float    temperature = 0.0f;
-    float    humidity    = 0.0f;
-    if (scd4x.readMeasurement(co2, temperature, humidity) || co2 == 0) return data;
-
-    data.co2         = co2;
-    data.temperature = temperature;
-    data.humidity    = humidity;
-    data.success     = true;
-    return data;
-}
-
-// Modbus CRC16 (polynomial 0xA001)
-static uint16_t modbusCalcCrc(const uint8_t* data, size_t len) {
-    uint16_t crc = 0xFFFF;
-    for (size_t i = 0; i < len; i++) {
-        crc ^= data[i];
-        for (int b = 0; b < 8; b++) {
-            crc = (crc & 0x0001) ? ((crc >> 1) ^ 0xA001) : (crc >> 1);
+    for (;;) {
+        if (scd41Latched.success || pollScd41()) {
+            Scd41Data data = scd41Latched;
+            scd41Latched   = {};
+            return data;
         }
+        if (scd41Mode != SCD41_MODE_SINGLE_SHOT) break;
+        if ((long)(millis() - (scd41SampleDueMs + SCD41_READY_MARGIN_MS)) >= 0) break;
+        delay(SCD41_READY_POLL_MS);
     }
-    return crc;
+    return Scd41Data{};
+}
+
+// 32-bit JSY register pair, high word first
+static uint32_t jsyU32(const uint16_t* regs, uint8_t reg) {
+    return ((uint32_t)regs[reg] << 16) | regs[reg + 1];
 }
 
-// Read JSY-MK-194G AC power meter via Modbus RTU over Serial1
-// NOTE: Verify register addresses against your specific JSY-MK-194G datasheet/firmware version
+// Read both channels of the JSY-MK-194G AC power meter in one Modbus
+// transaction over Serial1 (register map in config.h)
 Jsy194gData readJsy194g() {
     Jsy194gData data = {};
 
-    // Flush any stale bytes
-    while (Serial1.available()) Serial1.read();
-
-    // Build Modbus RTU request: device=0x01, FC=0x03, start=0x0000, count=8 registers
-    uint8_t request[8];
-    request[0] = 0x01; // Device address
-    request[1] = 0x03; // Function code: read holding registers
-    request[2] = 0x00; // Start register high byte
-    request[3] = 0x00; // Start register low byte
-    request[4] = 0x00; // Register count high byte
-    request[5] = 0x08; // Register count low byte
-    uint16_t crc = modbusCalcCrc(request, 6);
-    request[6] = crc & 0xFF;
-    request[7] = (crc >> 8) & 0xFF;
-
-    // Drive RS485 bus to transmit mode
-    if (boardConfig.jsyDePin >= 0) {
-        digitalWrite(boardConfig.jsyDePin, HIGH);
-    }
-    Serial1.write(request, 8);
-    Serial1.flush();
-
-    // Switch back to receive mode
-    if (boardConfig.jsyDePin >= 0) {
-        digitalWrite(boardConfig.jsyDePin, LOW);
-    }
-
-    // Expected response: addr(1) + FC(1) + byteCount(1) + data(16) + CRC(2) = JSY_RESPONSE_BYTES
-    const int expectedBytes = JSY_RESPONSE_BYTES;
-    uint32_t timeout = millis() + JSY_RESPONSE_TIMEOUT_MS;
-    while (Serial1.available() < expectedBytes && millis() < timeout) {
-        delay(1);
-    }
-    if (Serial1.available() < expectedBytes) return data; // Timeout
-
-    uint8_t response[JSY_RESPONSE_BYTES];
-    Serial1.readBytes(response, expectedBytes);
-
-    // Validate CRC
-    uint16_t respCrc = modbusCalcCrc(response, expectedBytes - 2);
-    if ((respCrc & 0xFF) != response[expectedBytes - 2] || ((respCrc >> 8) & 0xFF) != response[expectedBytes - 1]) {
-        return data; // CRC mismatch
-    }
-
-    // Parse registers from response bytes 3..18 (big-endian 16-bit each)
-    // Register map (JSY-MK-194G, verify against your datasheet):
-    // Reg 0: Voltage    ×0.01 V
-    // Reg 1: Current    ×0.01 A
-    // Reg 2+3: Power    32-bit signed, ×0.1 W
-    // Reg 4: Power factor ×0.001
-    // Reg 5: Frequency  ×0.01 Hz
-    // Reg 6+7: Energy   32-bit unsigned, ×1 Wh (converted to kWh below)
-    uint16_t rawVoltage = ((uint16_t)response[3]  << 8) | response[4];
-    uint16_t rawCurrent = ((uint16_t)response[5]  << 8) | response[6];
-    int32_t  rawPower   = (int32_t)(((uint32_t)response[7]  << 24) | ((uint32_t)response[8]  << 16)
-                                  | ((uint32_t)response[9]  <<  8) |  (uint32_t)response[10]);
-    uint16_t rawPf      = ((uint16_t)response[11] << 8) | response[12];
-    uint16_t rawFreq    = ((uint16_t)response[13] << 8) | response[14];
-    uint32_t rawEnergy  = ((uint32_t)response[15] << 24) | ((uint32_t)response[16] << 16)
-                        | ((uint32_t)response[17] <<  8) |  (uint32_t)response[18];
-
-    data.voltage     = rawVoltage / JSY_VOLTAGE_SCALE;
-    data.current     = rawCurrent / JSY_CURRENT_SCALE;
-    data.power       = rawPower   / JSY_POWER_SCALE;
-    data.powerFactor = rawPf      / JSY_PF_SCALE;
-    data.frequency   = rawFreq    / JSY_FREQ_SCALE;
-    data.energy      = (double)rawEnergy / 1000.0; // explicit double division for kWh precision
+    uint16_t regs[JSY_WORD_COUNT];
+    if (!modbusReadRegisters(JSY_SLAVE_ID, 0x03, JSY_REGISTER_START, JSY_REGISTER_COUNT, regs, JSY_REGISTER_BYTES)) {
+        return data; // Timeout, exception or CRC mismatch
+    }
+
+    for (uint8_t c = 0; c < JSY_CHANNELS; c++) {
+        const uint16_t* r = &regs[c * JSY_CHANNEL_STRIDE];
+        uint8_t direction = (c == 0) ? regs[JSY_REG_DIRECTION] >> 8 : regs[JSY_REG_DIRECTION] & 0xFF;
+
+        JsyChannel& ch = data.ch[c];
+        ch.voltage     = jsyU32(r, JSY_REG_VOLTAGE) / JSY_VOLTAGE_SCALE;
+        ch.current     = jsyU32(r, JSY_REG_CURRENT) / JSY_CURRENT_SCALE;
+        ch.exporting   = direction != 0;
+        ch.power       = jsyU32(r, JSY_REG_POWER)   / JSY_POWER_SCALE;
+        if (ch.exporting) ch.power = -ch.power; // register holds the magnitude
+        ch.powerFactor = jsyU32(r, JSY_REG_PF)      / JSY_PF_SCALE;
+        ch.energy      = jsyU32(r, JSY_REG_ENERGY)  / JSY_ENERGY_SCALE; // double for kWh precision
+    }
+    data.frequency   = jsyU32(regs, JSY_REG_FREQ) / JSY_FREQ_SCALE;
     data.success     = true;
     return data;
 }
@@ -3,8 +3,14 @@
 
 #include "globals.h"
 
-void        initScd41(int sdaPin, int sclPin);
+void        initScd41(int sdaPin, int sclPin, Scd41Mode mode, bool warm);
+void        startScd41Measurement();
+bool        pollScd41();
 void        initSht40(int sdaPin, int sclPin);
+void        powerOnDht();
+void        powerOffDht();
+void        initPms5003();
+void        setPmsPower(bool on);
 SensorData  readDhtSensor();
 SensorData  readSht40();
 float       readBatteryVoltage();
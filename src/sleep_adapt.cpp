@@ -0,0 +1,85 @@
+#include "sleep_adapt.h"
+
+RTC_DATA_ATTR static float    prevTemp     = NAN;
+RTC_DATA_ATTR static float    prevHumid    = NAN;
+RTC_DATA_ATTR static float    prevCo2      = NAN;
+RTC_DATA_ATTR static uint16_t prevInterval = 0; // chosen interval, 0 = none yet
+RTC_DATA_ATTR static uint16_t lastSleepS   = 0; // actual last sleep, including retries
+
+static SleepReason lastReason = SLEEP_FIXED;
+
+static const char* const reasonNames[SLEEP_REASON_COUNT] = {
+    "fixed", "stable", "temperature", "humidity", "co2", "no reading", "battery", "retry",
+};
+
+// Narrow factor to the one that brings this reading's change to about one
+// step per sample. Returns false when there is no pair of readings to compare.
+static bool stepFactor(float now, float& prev, float step, SleepReason source,
+                       float& factor, SleepReason& reason) {
+    if (isnan(now)) return false;
+    bool  compared = !isnan(prev);
+    float delta    = compared ? fabsf(now - prev) : 0.0f;
+    prev = now;
+    if (delta > 0.0f && step / delta < factor) {
+        factor = step / delta;
+        reason = source;
+    }
+    return compared;
+}
+
+uint16_t sleepAdaptNext(float temperature, float humidity, float co2, float volts) {
+    const uint16_t minS = boardConfig.minSleep;
+    const uint16_t maxS = boardConfig.maxSleep;
+    if (minS == 0 || maxS <= minS) {
+        lastReason = SLEEP_FIXED;
+        return boardConfig.timeToSleep;
+    }
+
+    // Signal dynamics
+    float       factor = SLEEP_ADAPT_MAX_FACTOR;
+    SleepReason reason = SLEEP_STABLE;
+    bool compared = stepFactor(temperature, prevTemp,  SLEEP_ADAPT_TEMP_STEP_C,    SLEEP_TEMPERATURE, factor, reason);
+    compared     |= stepFactor(humidity,    prevHumid, SLEEP_ADAPT_HUMID_STEP_PCT, SLEEP_HUMIDITY,    factor, reason);
+    compared     |= stepFactor(co2,         prevCo2,   SLEEP_ADAPT_CO2_STEP_PPM,   SLEEP_CO2,         factor, reason);
+    if (factor < SLEEP_ADAPT_MIN_FACTOR) factor = SLEEP_ADAPT_MIN_FACTOR;
+    if (!compared) {
+        factor = 1.0f;
+        reason = SLEEP_NO_READING;
+    }
+
+    float base     = prevInterval ? prevInterval : constrain(boardConfig.timeToSleep, minS, maxS);
+    float interval = base * factor;
+
+    // Battery: raise the floor as the cell discharges
+    if (volts > 0.0f && volts < SLEEP_ADAPT_BATT_FULL_V) {
+        float charge = (volts - SLEEP_ADAPT_BATT_LOW_V) / (SLEEP_ADAPT_BATT_FULL_V - SLEEP_ADAPT_BATT_LOW_V);
+        if (charge < 0.0f) charge = 0.0f;
+        float floorS = minS + (maxS - minS) * (1.0f - charge);
+        if (interval < floorS) {
+            interval = floorS;
+            reason   = SLEEP_BATTERY;
+        }
+    }
+
+    if (interval < minS) interval = minS;
+    if (interval > maxS) interval = maxS;
+    prevInterval = (uint16_t)lroundf(interval);
+    lastReason   = reason;
+    return prevInterval;
+}
+
+SleepReason sleepAdaptReason() {
+    return lastReason;
+}
+
+const char* sleepReasonName(SleepReason reason) {
+    return reason < SLEEP_REASON_COUNT ? reasonNames[reason] : "?";
+}
+
+void sleepAdaptSlept(uint16_t seconds) {
+    lastSleepS = seconds;
+}
+
+uint16_t sleepAdaptLastSeconds() {
+    return lastSleepS ? lastSleepS : boardConfig.timeToSleep;
+}
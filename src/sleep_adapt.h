@@ -0,0 +1,36 @@
+#ifndef SLEEP_ADAPT_H
+#define SLEEP_ADAPT_H
+
+#include "globals.h"
+
+// ── Adaptive sleep interval (battery boards) ──────────────────────────────
+// With BoardConfig.minSleep and maxSleep set, each wake chooses the next
+// sleep between them instead of using timeToSleep:
+//   1. Signal: each reading's change since the last wake is compared with
+//      its resolution step (SLEEP_ADAPT_*_STEP). The interval is scaled so
+//      the fastest-moving reading changes by about one step per sample —
+//      at most halved or doubled per wake.
+//   2. Battery: below SLEEP_ADAPT_BATT_FULL_V the shortest allowed interval
+//      rises linearly, reaching maxSleep at SLEEP_ADAPT_BATT_LOW_V.
+// The previous readings and interval live in RTC memory. Without bounds the
+// board sleeps timeToSleep as before.
+
+enum SleepReason : uint8_t {
+    SLEEP_FIXED,       // no bounds configured: timeToSleep
+    SLEEP_STABLE,      // nothing moved: lengthened
+    SLEEP_TEMPERATURE, // interval set by the fastest-moving reading
+    SLEEP_HUMIDITY,
+    SLEEP_CO2,
+    SLEEP_NO_READING,  // nothing to compare with the last wake: interval kept
+    SLEEP_BATTERY,     // raised to the battery floor
+    SLEEP_RETRY,       // ESP-NOW node: a sensor read failed, short retry sleep
+    SLEEP_REASON_COUNT
+};
+
+uint16_t    sleepAdaptNext(float temperature, float humidity, float co2, float volts);
+SleepReason sleepAdaptReason();      // why the last sleepAdaptNext() chose its interval
+const char* sleepReasonName(SleepReason reason);
+void        sleepAdaptSlept(uint16_t seconds); // called by deepSleep()
+uint16_t    sleepAdaptLastSeconds(); // sleep before this wake (timeToSleep on first boot)
+
+#endif // SLEEP_ADAPT_H
@@ -0,0 +1,190 @@
+#include "web_events.h"
+#include "ota.h"
+#include <WiFi.h>
+#include <lwip/sockets.h>
+
+static WiFiServer eventServer(WEB_EVENTS_PORT);
+static WiFiClient subscribers[WEB_EVENTS_MAX_CLIENTS];
+static bool       started    = false;
+static uint32_t   lastSendMs = 0;
+
+// Queued by loop() under the web state lock, drained by the web task
+static bool    readingsPending = false;
+static char    nodeQueue[WEB_EVENTS_NODE_QUEUE][WEB_EVENTS_NODE_JSON_LEN];
+static uint8_t nodeHead  = 0;
+static uint8_t nodeCount = 0;
+
+// Web task only: the event being sent
+static char eventBuf[WEB_DATA_SNAPSHOT_LEN + 32];
+
+// Web task only: the connection whose request head is being read. Its bytes
+// are taken as they arrive, over as many ticks as needed, so a slow client
+// never holds up the web task; further connections wait in the backlog.
+static struct {
+    WiFiClient    client;
+    char          request[48]; // first line
+    size_t        len;
+    uint32_t      tail;        // last four bytes received: 0x0D0A0D0A ends the head
+    bool          firstLine;
+    unsigned long sinceMs;
+} handshake;
+
+void initWebEvents() {
+    eventServer.begin();
+    eventServer.setNoDelay(true);
+    started = true;
+}
+
+// Send without waiting: WiFiClient::write() retries a full send buffer with
+// 1 s selects, about 10 s in all, which would stall the web task. An event
+// that does not fit in the socket buffer at once means the subscriber has
+// stopped reading; a partial event would corrupt the stream, so it is dropped.
+static bool sendNow(WiFiClient& c, const char* data, size_t len) {
+    return c.connected() && send(c.fd(), data, len, MSG_DONTWAIT) == (ssize_t)len;
+}
+
+static void sendToAll(const char* data, size_t len) {
+    for (WiFiClient& c : subscribers) {
+        if (!c) continue;
+        if (!sendNow(c, data, len)) {
+            c.stop();
+            c = WiFiClient();
+        }
+    }
+    lastSendMs = millis();
+}
+
+static size_t formatEvent(const char* event, const char* json) {
+    int n = snprintf(eventBuf, sizeof(eventBuf), "event: %s\ndata: %s\n\n", event, json);
+    return (n > 0 && (size_t)n < sizeof(eventBuf)) ? n : 0;
+}
+
+static size_t formatSnapshotEvent() {
+    char json[WEB_DATA_SNAPSHOT_LEN];
+    webDataSnapshotCopy(json, sizeof(json));
+    return formatEvent("data", json);
+}
+
+// Subscribe a connection whose request head has been read, or refuse it
+static void finishHandshake(WiFiClient& client, bool isEventsRequest) {
+    if (!isEventsRequest) {
+        client.print("HTTP/1.1 404 Not Found\r\nConnection: close\r\nContent-Length: 0\r\n\r\n");
+        client.stop();
+        return;
+    }
+    WiFiClient* slot = nullptr;
+    for (WiFiClient& c : subscribers) {
+        if (!c) {
+            slot = &c;
+            break;
+        }
+    }
+    if (!slot) {
+        client.print("HTTP/1.1 503 Service Unavailable\r\nAccess-Control-Allow-Origin: *\r\n"
+                     "Connection: close\r\nContent-Length: 0\r\n\r\n");
+        client.stop();
+        return;
+    }
+    client.print("HTTP/1.1 200 OK\r\n"
+                 "Content-Type: text/event-stream\r\n"
+                 "Cache-Control: no-cache\r\n"
+                 "Connection: keep-alive\r\n"
+                 "Access-Control-Allow-Origin: *\r\n\r\n"
+                 "retry: 5000\n\n");
+    size_t n = formatSnapshotEvent();
+    if (n && !sendNow(client, eventBuf, n)) {
+        client.stop();
+        return;
+    }
+    *slot = client;
+}
+
+// Read what has arrived of a connection's request head, then subscribe it
+// (stream headers and the current snapshot) or refuse it. A head not complete
+// within WEB_EVENTS_HANDSHAKE_MS is refused.
+static void acceptSubscriber() {
+    if (!handshake.client) {
+        handshake.client = eventServer.available();
+        if (!handshake.client) return;
+        handshake.len       = 0;
+        handshake.tail      = 0;
+        handshake.firstLine = true;
+        handshake.sinceMs   = millis();
+    }
+
+    WiFiClient& client = handshake.client;
+    while (handshake.tail != 0x0D0A0D0AUL) {
+        int c = client.read();
+        if (c < 0) break;
+        handshake.tail = (handshake.tail << 8) | (uint8_t)c;
+        if (c == '\n') handshake.firstLine = false;
+        else if (handshake.firstLine && c != '\r' && handshake.len < sizeof(handshake.request) - 1)
+            handshake.request[handshake.len++] = (char)c;
+    }
+    if (handshake.tail != 0x0D0A0D0AUL && millis() - handshake.sinceMs < WEB_EVENTS_HANDSHAKE_MS) {
+        return; // rest of the head on a later tick
+    }
+    handshake.request[handshake.len] = '\0';
+    finishHandshake(client, handshake.tail == 0x0D0A0D0AUL && strncmp(handshake.request, "GET /events", 11) == 0);
+    handshake.client = WiFiClient();
+}
+
+void webEventsTick() {
+    if (!started) return;
+    acceptSubscriber();
+
+    webStateLock();
+    bool readings   = readingsPending;
+    readingsPending = false;
+    webStateUnlock();
+
+    if (readings && webEventSubscribers() > 0) {
+        size_t n = formatSnapshotEvent();
+        if (n) sendToAll(eventBuf, n);
+    }
+
+    for (;;) {
+        char json[WEB_EVENTS_NODE_JSON_LEN];
+        webStateLock();
+        bool have = nodeCount > 0;
+        if (have) {
+            memcpy(json, nodeQueue[nodeHead], sizeof(json));
+            nodeHead = (nodeHead + 1) % WEB_EVENTS_NODE_QUEUE;
+            nodeCount--;
+        }
+        webStateUnlock();
+        if (!have) break;
+        size_t n = formatEvent("node", json);
+        if (n && webEventSubscribers() > 0) sendToAll(eventBuf, n);
+    }
+
+    if (millis() - lastSendMs >= WEB_EVENTS_KEEPALIVE_MS) {
+        sendToAll(":\n\n", 3);
+    }
+}
+
+void webPushReadings() {
+    WebStateGuard guard;
+    readingsPending = true;
+}
+
+// Full queue: the oldest packet is dropped
+void webPushNode(const char* json) {
+    WebStateGuard guard;
+    if (nodeCount == WEB_EVENTS_NODE_QUEUE) {
+        nodeHead = (nodeHead + 1) % WEB_EVENTS_NODE_QUEUE;
+        nodeCount--;
+    }
+    uint8_t slot = (nodeHead + nodeCount) % WEB_EVENTS_NODE_QUEUE;
+    strncpy(nodeQueue[slot], json, WEB_EVENTS_NODE_JSON_LEN - 1);
+    nodeQueue[slot][WEB_EVENTS_NODE_JSON_LEN - 1] = '\0';
+    nodeCount++;
+}
+
+uint8_t webEventSubscribers() {
+    uint8_t n = 0;
+    for (WiFiClient& c : subscribers) {
+        if (c) n++;
+    }
+    return n;
+}
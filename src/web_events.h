@@ -0,0 +1,29 @@
+#ifndef WEB_EVENTS_H
+#define WEB_EVENTS_H
+
+#include "globals.h"
+
+// ── Live updates for the status page (Server-Sent Events, mains boards) ──
+// Browsers subscribe with GET /events on WEB_EVENTS_PORT; at most
+// WEB_EVENTS_MAX_CLIENTS at a time, further subscribers get 503 and the page
+// falls back to polling /data. The stream lives on its own port because the
+// WebServer on port 80 serves one connection at a time, so a stream held
+// open there would block every other request.
+//
+// Events (JSON data):
+//   data  the /data snapshot — on subscribe and once after each mains cycle's
+//         readings and JSY publish
+//   node  one ESP-NOW packet forwarded by the gateway
+// A comment line goes out every WEB_EVENTS_KEEPALIVE_MS when idle so dead
+// subscribers are found and dropped.
+//
+// The push functions are called from loop(): they only queue, under the web
+// state lock. webEventsTick() runs on the web task and does all socket work.
+
+void    initWebEvents();
+void    webEventsTick();
+void    webPushReadings();
+void    webPushNode(const char* json);
+uint8_t webEventSubscribers();
+
+#endif // WEB_EVENTS_H
@@ -0,0 +1,130 @@
+function tryUpdate(id, value) {
+    var el = document.getElementById(id);
+    if (el) el.innerHTML = value;
+}
+
+// Uptime is not in /data (it would change every poll); advance it here
+var bootMs = 0;
+function tickUptime() {
+    var el = document.getElementById('uptime');
+    if (!el) return;
+    if (!bootMs) bootMs = Date.now() - el.getAttribute('data-s') * 1000;
+    var s = Math.floor((Date.now() - bootMs) / 1000);
+    var d = Math.floor(s / 86400), p = function(n) { return (n < 10 ? '0' : '') + n; };
+    el.innerHTML = d + (d == 1 ? ' day, ' : ' days, ') + p(Math.floor(s % 86400 / 3600)) + ':' +
+                   p(Math.floor(s % 3600 / 60)) + ':' + p(s % 60);
+}
+
+function applyData(data) {
+    tryUpdate('time',      data.time);
+    tryUpdate('temp',      data.temperature);
+    tryUpdate('humid',     data.humidity);
+    tryUpdate('voltage',   data.voltage);
+    tryUpdate('soc',       data.soc);
+    tryUpdate('battDays',  data.battDays);
+    tryUpdate('co2',       data.co2);
+    tryUpdate('pm1',       data.pm1);
+    tryUpdate('pm25',      data.pm25);
+    tryUpdate('pm10',      data.pm10);
+    tryUpdate('acVoltage', data.acVoltage);
+    tryUpdate('acCurrent', data.acCurrent);
+    tryUpdate('acPower',   data.acPower);
+    tryUpdate('acPf',      data.acPf);
+    tryUpdate('acFreq',    data.acFreq);
+    tryUpdate('acEnergy',  data.acEnergy);
+    tryUpdate('acDir',     data.acDir);
+    tryUpdate('ac2Current', data.ac2Current);
+    tryUpdate('ac2Power',  data.ac2Power);
+    tryUpdate('ac2Energy', data.ac2Energy);
+    tryUpdate('ac2Dir',    data.ac2Dir);
+}
+
+// One row per ESP-NOW node, replaced on each of its packets
+function applyNode(node) {
+    var table = document.getElementById('nodes');
+    if (!table) return;
+    var id = 'node-' + node.room, row = document.getElementById(id);
+    if (!row) {
+        row = table.insertRow(-1);
+        row.id = id;
+        row.insertCell(0);
+        row.insertCell(1);
+    }
+    var f = function(v, unit) { return v === null ? '-' : v + unit; };
+    row.cells[0].textContent = node.room;
+    row.cells[1].textContent = f(node.t, '\u00b0C') + ' ' + f(node.h, '%') + ' ' + f(node.co2, 'ppm') + ' ' +
+                               f(node.bat, 'V') + ' ' + f(node.soc, '%') + ' (' + node.time + ')';
+}
+
+// Live updates: the firmware pushes readings as they arrive. Polling only
+// runs until the stream is open, or when it is refused (subscriber cap).
+var live = false, eventsStarted = false;
+function startEvents(port) {
+    if (eventsStarted || !port || !window.EventSource) return;
+    eventsStarted = true;
+    var es = new EventSource('http://' + location.hostname + ':' + port + '/events');
+    es.onopen = function() { live = true; };
+    es.onerror = function() { live = false; }; // reconnecting or refused: poll meanwhile
+    es.addEventListener('data', function(e) { live = true; applyData(JSON.parse(e.data)); });
+    es.addEventListener('node', function(e) { applyNode(JSON.parse(e.data)); });
+}
+
+// Conditional poll: an unchanged snapshot comes back as a bodiless 304
+var dataEtag = null;
+function updateData() {
+    if (live) return;
+    var xhttp = new XMLHttpRequest();
+    xhttp.onreadystatechange = function() {
+        if (this.readyState == 4 && this.status == 200) {
+            dataEtag = this.getResponseHeader('ETag');
+            var data = JSON.parse(this.responseText);
+            applyData(data);
+            startEvents(data.eventsPort);
+        }
+    };
+    xhttp.open("GET", "/data", true);
+    if (dataEtag) xhttp.setRequestHeader('If-None-Match', dataEtag);
+    xhttp.send();
+}
+
+function loadHistory() {
+    var sel = document.getElementById('histMetric');
+    var canvas = document.getElementById('histChart');
+    if (!sel || !canvas) return;
+    var xhttp = new XMLHttpRequest();
+    xhttp.onreadystatechange = function() {
+        if (this.readyState != 4 || this.status != 200) return;
+        var rows = this.responseText.trim().split('\n').slice(1);
+        var t = [], v = [];
+        rows.forEach(function(r) {
+            var f = r.split(',');
+            t.push(+f[0]);
+            v.push(+f[1]);
+        });
+        var ctx = canvas.getContext('2d');
+        ctx.clearRect(0, 0, canvas.width, canvas.height);
+        if (v.length < 2) return;
+        var lo = Math.min.apply(null, v), hi = Math.max.apply(null, v);
+        if (hi == lo) { hi += 1; lo -= 1; }
+        var t0 = t[0], span = t[t.length - 1] - t0 || 1, h = canvas.height - 14;
+        ctx.strokeStyle = '#007bff';
+        ctx.beginPath();
+        for (var i = 0; i < v.length; i++) {
+            var x = (t[i] - t0) / span * canvas.width;
+            var y = 7 + (hi - v[i]) / (hi - lo) * h;
+            if (i == 0 || t[i] - t[i - 1] > 120) ctx.moveTo(x, y); else ctx.lineTo(x, y);
+        }
+        ctx.stroke();
+        ctx.fillStyle = '#555';
+        ctx.font = '10px Arial';
+        ctx.fillText(hi.toFixed(1), 2, 10);
+        ctx.fillText(lo.toFixed(1), 2, canvas.height - 2);
+    };
+    xhttp.open('GET', '/history?metric=' + sel.value + '&format=csv', true);
+    xhttp.send();
+}
+
+window.onload = function() { updateData(); loadHistory(); };
+setInterval(updateData, 5000);
+setInterval(tickUptime, 1000);
+setInterval(loadHistory, 60000);